@@ -0,0 +1,70 @@
+// Global allocation counter for benchmarks. Include from exactly one
+// translation unit per benchmark executable.
+#ifndef CPPMCP_BENCH_ALLOC_COUNTER_HPP
+#define CPPMCP_BENCH_ALLOC_COUNTER_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace bench {
+
+struct AllocStats {
+    size_t count;
+    size_t bytes;
+};
+
+inline std::atomic<size_t> g_alloc_count{0};
+inline std::atomic<size_t> g_alloc_bytes{0};
+
+inline AllocStats alloc_snapshot() {
+    return {g_alloc_count.load(std::memory_order_relaxed), g_alloc_bytes.load(std::memory_order_relaxed)};
+}
+
+// Allocations made while running fn
+template <typename Fn>
+AllocStats count_allocations(Fn&& fn) {
+    AllocStats before = alloc_snapshot();
+    fn();
+    AllocStats after = alloc_snapshot();
+    return {after.count - before.count, after.bytes - before.bytes};
+}
+
+} // namespace bench
+
+// Every replaceable form is defined, so each allocation is counted and
+// each is released with the free matching its malloc. Aligned forms are
+// left to the library: nothing benchmarked over-aligns.
+inline void* bench_allocate(size_t size) {
+    bench::g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    bench::g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// Not inlined: GCC's -Wmismatched-new-delete flags a free it can see
+// being applied to the result of operator new
+[[gnu::noinline]] inline void bench_release(void* p) noexcept { std::free(p); }
+
+void* operator new(size_t size) {
+    if (void* p = bench_allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    if (void* p = bench_allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return bench_allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return bench_allocate(size); }
+
+void operator delete(void* p) noexcept { bench_release(p); }
+void operator delete[](void* p) noexcept { bench_release(p); }
+void operator delete(void* p, size_t) noexcept { bench_release(p); }
+void operator delete[](void* p, size_t) noexcept { bench_release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { bench_release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { bench_release(p); }
+
+#endif // CPPMCP_BENCH_ALLOC_COUNTER_HPP
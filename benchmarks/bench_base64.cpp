@@ -0,0 +1,52 @@
+// Blob benchmark: base64 encoding throughput, and resources/read for binary
+// resources of increasing size.
+#include <cppmcp/base64.hpp>
+#include <cppmcp/mcp_server.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    const size_t sizes[] = {4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+
+    mcp::MCPServer server("bench-server");
+    for (size_t size : sizes) {
+        std::string bytes(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            bytes[i] = static_cast<char>(i * 2654435761u >> 13);
+        }
+        server.add_blob_resource("blob://" + std::to_string(size), "blob", "Random bytes",
+                                 "application/octet-stream", [bytes] { return bytes; });
+    }
+    server.handle_message_raw({{"jsonrpc", "2.0"}, {"id", 0}, {"method", "initialize"}});
+
+    std::printf("%10s %14s %18s\n", "bytes", "encode MB/s", "resources/read ms");
+    for (size_t size : sizes) {
+        std::string bytes(size, '\x5a');
+        const int iterations = static_cast<int>(256 * 1024 * 1024 / size);
+
+        std::string out;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            out.clear();
+            mcp::base64_encode_append(out, bytes.data(), bytes.size());
+        }
+        double encode = size * static_cast<double>(iterations) / seconds_since(start) / (1024 * 1024);
+
+        json message = {{"jsonrpc", "2.0"}, {"id", 1}, {"method", "resources/read"},
+                        {"params", {{"uri", "blob://" + std::to_string(size)}}}};
+        const int reads = iterations / 16 + 1;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < reads; ++i) {
+            server.handle_message_raw(message);
+        }
+        double read = seconds_since(start) * 1000 / reads;
+
+        std::printf("%10zu %14.0f %18.3f\n", size, encode, read);
+    }
+    return 0;
+}
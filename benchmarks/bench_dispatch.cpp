@@ -0,0 +1,54 @@
+// Dispatch benchmark: allocations and time per tools/call with large arguments.
+// A copy of the arguments anywhere on the dispatch path shows up as at
+// least payload-size bytes allocated per call.
+#include "alloc_counter.hpp"
+#include <cppmcp/mcp_server.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static json request(int id, const std::string& method, json params) {
+    return {{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", std::move(params)}};
+}
+
+int main() {
+    mcp::MCPServer server("bench-server");
+    server.add_tool("measure", "Returns the argument size", json::object(), [](const json& args) {
+        return json(args["csv_data"].get_ref<const std::string&>().size());
+    });
+    server.handle_message_raw(request(0, "initialize", json::object()));
+
+    bool copies_found = false;
+    std::printf("%12s %12s %14s %12s\n", "payload", "allocs/call", "bytes/call", "us/call");
+
+    for (size_t payload : {size_t(1) << 10, size_t(1) << 20, size_t(8) << 20, size_t(64) << 20}) {
+        json message = request(1, "tools/call", {
+            {"name", "measure"},
+            {"arguments", {{"csv_data", std::string(payload, 'x')}}}
+        });
+
+        const int iterations = payload >= (size_t(8) << 20) ? 20 : 200;
+        std::string response;
+        auto start = std::chrono::steady_clock::now();
+        bench::AllocStats stats = bench::count_allocations([&] {
+            for (int i = 0; i < iterations; ++i) {
+                response = server.handle_message_raw(message);
+            }
+        });
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+        size_t bytes = stats.bytes / iterations;
+        std::printf("%12zu %12zu %14zu %12.1f\n", payload, stats.count / iterations, bytes, us);
+
+        if (payload >= (size_t(1) << 20) && bytes >= payload) {
+            copies_found = true;
+        }
+    }
+
+    if (copies_found) {
+        std::printf("FAIL: arguments are copied on the dispatch path\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// JSON arena benchmark: parse and release request-sized documents on several
+// threads at once, with heap-backed and arena-backed documents.
+#include <cppmcp/json_arena.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using heap_json = nlohmann::json;
+using arena_json = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                                        std::int64_t, std::uint64_t, double,
+                                        mcp::ArenaAllocator>;
+
+static std::string make_request() {
+    heap_json rows = heap_json::array();
+    for (int i = 0; i < 200; ++i) {
+        rows.push_back({{"id", i}, {"name", "row"}, {"tags", {"a", "b"}}, {"score", i * 0.5}});
+    }
+    return heap_json{
+        {"jsonrpc", "2.0"}, {"id", 1}, {"method", "tools/call"},
+        {"params", {{"name", "ingest"}, {"arguments", {{"rows", rows}}}}}
+    }.dump();
+}
+
+template <typename Json, bool UseArena>
+static double run(const std::string& body, unsigned threads, int requests_per_thread) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&body, requests_per_thread] {
+            for (int i = 0; i < requests_per_thread; ++i) {
+                if (UseArena) {
+                    mcp::JsonArena::RequestScope scope;
+                    Json request = Json::parse(body);
+                    Json response = {{"id", request["id"]}, {"result", {{"count", request["params"]["arguments"]["rows"].size()}}}};
+                } else {
+                    Json request = Json::parse(body);
+                    Json response = {{"id", request["id"]}, {"result", {{"count", request["params"]["arguments"]["rows"].size()}}}};
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / (threads * requests_per_thread);
+}
+
+int main() {
+    std::string body = make_request();
+    const int requests_per_thread = 2000;
+
+    std::printf("request size: %zu bytes\n", body.size());
+    std::printf("%8s %14s %14s\n", "threads", "heap us/req", "arena us/req");
+    unsigned max_threads = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        double heap = run<heap_json, false>(body, threads, requests_per_thread);
+        double arena = run<arena_json, true>(body, threads, requests_per_thread);
+        std::printf("%8u %14.1f %14.1f\n", threads, heap, arena);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// Parse benchmark: time per message with a full parse up front versus lazy
+// parsing from a scan of the JSON-RPC envelope.
+#include <cppmcp/mcp_server.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static json request(int id, const std::string& method, json params) {
+    return {{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", std::move(params)}};
+}
+
+static double run(mcp::MCPServer& server, const std::string& body, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        server.handle_message_text(body);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+}
+
+int main() {
+    json rows = json::array();
+    for (int i = 0; i < 2000; ++i) {
+        rows.push_back({{"id", i}, {"name", "row " + std::to_string(i)}, {"tags", {"a", "b"}}, {"score", i * 0.5}});
+    }
+
+    struct Case {
+        const char* name;
+        std::string body;
+    };
+    const Case cases[] = {
+        {"ping", request(1, "ping", json::object()).dump()},
+        {"tools/list", request(1, "tools/list", json::object()).dump()},
+        {"tools/call", request(1, "tools/call", {{"name", "ingest"}, {"arguments", {{"rows", rows}}}}).dump()},
+        {"unknown tool", request(1, "tools/call", {{"name", "missing"}, {"arguments", {{"rows", rows}}}}).dump()},
+    };
+
+    mcp::MCPServer eager("bench-server");
+    mcp::MCPServer lazy("bench-server");
+    for (auto* server : {&eager, &lazy}) {
+        server->add_tool("ingest", "Counts rows", json::object(), [](const json& args) {
+            return json(args["rows"].size());
+        });
+        server->handle_message_raw(request(0, "initialize", json::object()));
+    }
+    lazy.set_lazy_parsing(true);
+
+    std::printf("%14s %10s %14s %14s\n", "message", "bytes", "full us/msg", "lazy us/msg");
+    for (const auto& c : cases) {
+        const int iterations = c.body.size() > 4096 ? 200 : 20000;
+        double full = run(eager, c.body, iterations);
+        double scanned = run(lazy, c.body, iterations);
+        std::printf("%14s %10zu %14.2f %14.2f\n", c.name, c.body.size(), full, scanned);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+// STDIO benchmark: messages per second through the fd-level transport
+// versus the previous iostream loop (getline, then endl and flush per
+// response), over the same input file with output to a pipe drained by
+// another thread, as a client would.
+#include <cppmcp/mcp_server.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Pipe whose read end is drained by a background thread
+struct DrainedPipe {
+    int fds[2];
+    std::thread drain;
+
+    DrainedPipe() {
+        if (pipe(fds) != 0) {
+            std::perror("pipe");
+            std::exit(1);
+        }
+        drain = std::thread([fd = fds[0]] {
+            char buffer[65536];
+            while (read(fd, buffer, sizeof(buffer)) > 0) {
+            }
+        });
+    }
+    ~DrainedPipe() {
+        close(fds[1]);
+        drain.join();
+        close(fds[0]);
+    }
+    std::string path() const { return "/proc/self/fd/" + std::to_string(fds[1]); }
+};
+
+int main() {
+    const int messages = 200000;
+
+    mcp::MCPServer server("bench-server");
+    server.add_tool("echo", "Echoes its input", json::object(), [](const json& args) { return args; });
+
+    char path[] = "/tmp/bench_stdio_XXXXXX";
+    int fd = mkstemp(path);
+    {
+        std::ofstream input(path);
+        input << json({{"jsonrpc", "2.0"}, {"id", 0}, {"method", "initialize"}}).dump() << "\n";
+        std::string call = json({{"jsonrpc", "2.0"}, {"id", 1}, {"method", "tools/call"},
+                                 {"params", {{"name", "echo"}, {"arguments", {{"text", "hello"}}}}}}).dump();
+        std::string ping = json({{"jsonrpc", "2.0"}, {"id", 2}, {"method", "ping"}}).dump();
+        for (int i = 0; i < messages; ++i) {
+            input << (i % 2 ? ping : call) << "\n";
+        }
+    }
+
+    // Previous path: iostreams, one flush per response
+    double iostream_rate;
+    {
+        DrainedPipe pipe;
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream in(path);
+        std::ofstream out(pipe.path());
+        for (std::string line; std::getline(in, line);) {
+            std::string response = server.handle_message_text(line);
+            if (!response.empty()) {
+                out << response << std::endl;
+                out.flush();
+            }
+        }
+        iostream_rate = messages / seconds_since(start);
+    }
+
+    // Transport: buffered reads, coalesced writev
+    double transport_rate;
+    {
+        DrainedPipe pipe;
+        int in = open(path, O_RDONLY);
+        auto start = std::chrono::steady_clock::now();
+        server.run_stdio(in, pipe.fds[1]);
+        transport_rate = messages / seconds_since(start);
+        close(in);
+    }
+
+    close(fd);
+    unlink(path);
+
+    std::printf("%12s %14s\n", "path", "msgs/sec");
+    std::printf("%12s %14.0f\n", "iostream", iostream_rate);
+    std::printf("%12s %14.0f\n", "transport", transport_rate);
+    return 0;
+}
@@ -10,81 +10,63 @@
 #include <cmath>
 #include <fstream>
 
+// Tool arguments: the input schema is generated from these structs and
+// requests are decoded into them
+struct BinaryArgs {
+    double a;
+    double b;
+};
+CPPMCP_TOOL_ARGS(BinaryArgs, a, b)
+
+struct PowerArgs {
+    double base;
+    double exponent;
+};
+CPPMCP_TOOL_ARGS(PowerArgs, base, exponent)
+
+struct TextArgs {
+    std::string text;
+};
+CPPMCP_TOOL_ARGS(TextArgs, text)
+
 int main(int argc, char* argv[]) {
     mcp::MCPServer server("tools-example", "1.0.0");
     
     // ========== Tools ==========
     
     // Math tool: Add
-    server.add_tool(
+    server.add_tool<BinaryArgs>(
         "add",
         "Add two numbers",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"a", {{"type", "number"}}},
-                {"b", {{"type", "number"}}}
-            }},
-            {"required", {"a", "b"}}
-        },
-        [](const json& args) -> json {
-            double result = args["a"].get<double>() + args["b"].get<double>();
-            return {{"result", result}};
+        [](const BinaryArgs& args) -> json {
+            return {{"result", args.a + args.b}};
         }
     );
     
     // Math tool: Multiply
-    server.add_tool(
+    server.add_tool<BinaryArgs>(
         "multiply",
         "Multiply two numbers",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"a", {{"type", "number"}}},
-                {"b", {{"type", "number"}}}
-            }},
-            {"required", {"a", "b"}}
-        },
-        [](const json& args) -> json {
-            double result = args["a"].get<double>() * args["b"].get<double>();
-            return {{"result", result}};
+        [](const BinaryArgs& args) -> json {
+            return {{"result", args.a * args.b}};
         }
     );
     
     // Math tool: Power
-    server.add_tool(
+    server.add_tool<PowerArgs>(
         "power",
         "Calculate a^b",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"base", {{"type", "number"}}},
-                {"exponent", {{"type", "number"}}}
-            }},
-            {"required", {"base", "exponent"}}
-        },
-        [](const json& args) -> json {
-            double result = std::pow(
-                args["base"].get<double>(),
-                args["exponent"].get<double>()
-            );
-            return {{"result", result}};
+        [](const PowerArgs& args) -> json {
+            return {{"result", std::pow(args.base, args.exponent)}};
         }
     );
     
     // String tool: Uppercase
-    server.add_tool(
+    server.add_tool<TextArgs>(
         "uppercase",
         "Convert text to uppercase",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"text", {{"type", "string"}}}
-            }},
-            {"required", {"text"}}
-        },
-        [](const json& args) -> json {
-            std::string text = args["text"];
+        [](const TextArgs& args) -> json {
+            std::string text = args.text;
             for (auto& c : text) c = std::toupper(c);
             return {{"result", text}};
         }
@@ -0,0 +1,22 @@
+#ifndef MCP_BASE64_HPP
+#define MCP_BASE64_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace mcp {
+
+// Standard base64 (RFC 4648) with padding
+std::string base64_encode(const void* data, size_t size);
+std::string base64_encode(const std::string& data);
+
+// Append the encoding of data to out, written in place after a single
+// resize; SSE2 accelerated where available
+void base64_encode_append(std::string& out, const void* data, size_t size);
+
+// Decode base64 text; returns false on malformed input
+bool base64_decode(const std::string& encoded, std::string& decoded);
+
+} // namespace mcp
+
+#endif // MCP_BASE64_HPP
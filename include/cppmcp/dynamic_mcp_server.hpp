@@ -1,14 +1,13 @@
 #pragma once
 
 #include "mcp_server.hpp"
-#include <nlohmann/json.hpp>
+#include "json.hpp"
 #include <string>
 #include <vector>
 #include <map>
 #include <functional>
 #include <memory>
 
-using json = nlohmann::json;
 using mcp::MCPServer;
 using mcp::Tool;
 
@@ -0,0 +1,94 @@
+#ifndef MCP_EVENT_LOOP_HPP
+#define MCP_EVENT_LOOP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mcp {
+
+// Reactor shared by the transports: one thread waiting in epoll on file
+// descriptors, woken through an eventfd when another thread posts work,
+// with timers kept in a heap so the wait ends at the earliest deadline.
+// Every callback runs on the loop thread and must not block.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    using FdCallback = std::function<void(uint32_t events)>;
+    using TimerId = uint64_t;
+
+    // Starts the loop thread
+    EventLoop();
+
+    // Stops and joins the loop thread; timers and posted callbacks that
+    // haven't run are dropped
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Run callback on the loop thread, after those posted before it.
+    // Safe to call from any thread.
+    void post(Callback callback);
+
+    // Run callback on the loop thread once the time comes; returns an id
+    // for cancel_timer. Safe to call from any thread.
+    TimerId add_timer(Clock::duration delay, Callback callback);
+    TimerId add_timer_at(Clock::time_point when, Callback callback);
+
+    // Drop a timer that hasn't fired; no effect once it has
+    void cancel_timer(TimerId id);
+
+    // Call callback with the ready events (EPOLLIN, EPOLLOUT, ...) whenever
+    // fd is ready for one of events. Returns false if fd can't be watched,
+    // e.g. a regular file, which is always ready.
+    bool watch(int fd, uint32_t events, FdCallback callback);
+
+    // Stop watching fd. Off the loop thread, waits until the loop has let
+    // go of the callback, so whatever it refers to may then be destroyed.
+    void unwatch(int fd);
+
+    // Run callback on the loop thread and wait for it to return, e.g. to
+    // change state that timer callbacks read without locking
+    void call(const Callback& callback);
+
+    bool in_loop_thread() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+private:
+    struct Timer {
+        Clock::time_point when;
+        TimerId id;
+        bool operator>(const Timer& other) const { return when > other.when; }
+    };
+
+    void run();
+    void wake();
+    int wait_timeout_ms();
+    void run_timers();
+    void run_posted();
+
+    int epoll_fd_;
+    int wake_fd_;
+    bool stopping_;  // Guarded by mutex_
+
+    std::mutex mutex_;
+    std::deque<Callback> posted_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::unordered_map<TimerId, Callback> timer_callbacks_;  // Cancelled timers are absent
+    TimerId next_timer_id_;
+    std::unordered_map<int, std::shared_ptr<FdCallback>> watches_;
+
+    std::thread thread_;
+};
+
+} // namespace mcp
+
+#endif // MCP_EVENT_LOOP_HPP
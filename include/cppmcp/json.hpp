@@ -0,0 +1,24 @@
+#ifndef MCP_JSON_HPP
+#define MCP_JSON_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// JSON document type used throughout the library. With
+// CPPMCP_ENABLE_JSON_ARENA, documents allocate their nodes from the
+// per-request JsonArena of the handling thread instead of the heap; code
+// that names nlohmann::json directly must use this alias instead.
+#ifdef CPPMCP_ENABLE_JSON_ARENA
+#include "json_arena.hpp"
+
+using json = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                                  std::int64_t, std::uint64_t, double,
+                                  mcp::ArenaAllocator>;
+#else
+using json = nlohmann::json;
+#endif
+
+#endif // MCP_JSON_HPP
@@ -0,0 +1,116 @@
+#ifndef MCP_JSON_ARENA_HPP
+#define MCP_JSON_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace mcp {
+
+// Bump allocator backing the JSON documents of one request at a time.
+// Each allocation carries a small header naming its chunk, so memory can
+// be released from any thread and documents may safely outlive the
+// request: a chunk still holding live allocations at reset() is handed
+// off and freed by its last deallocation instead of being reused.
+class JsonArena {
+public:
+    static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+    explicit JsonArena(size_t chunk_size = kDefaultChunkSize);
+    ~JsonArena();
+
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+
+    // Memory aligned for any scalar type. Large blocks go to the heap.
+    void* allocate(size_t bytes);
+
+    // Start over for the next request in one step: chunks whose
+    // allocations have all been released are rewound for reuse
+    void reset();
+
+    // Bytes handed out from chunks since the last reset
+    size_t bytes_allocated() const { return bytes_allocated_; }
+
+    // Allocate from the current arena of this thread, or the heap
+    static void* allocate_current(size_t bytes);
+    static void deallocate(void* pointer) noexcept;
+
+    // Arena installed on this thread, or nullptr
+    static JsonArena* current();
+
+    // This thread's own arena, created on first use
+    static JsonArena& thread_arena();
+
+    // Installs an arena as current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(JsonArena& arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        JsonArena* previous_;
+    };
+
+    // Makes this thread's arena current for one request and resets it
+    // when the request is done
+    class RequestScope {
+    public:
+        RequestScope() : scope_(thread_arena()) {}
+        ~RequestScope() { thread_arena().reset(); }
+
+        RequestScope(const RequestScope&) = delete;
+        RequestScope& operator=(const RequestScope&) = delete;
+
+    private:
+        Scope scope_;
+    };
+
+private:
+    struct Chunk;
+
+    Chunk* next_chunk();
+
+    size_t chunk_size_;
+    std::vector<Chunk*> chunks_;
+    size_t active_;
+    size_t bytes_allocated_;
+};
+
+// Stateless allocator routing through JsonArena, for use as the
+// AllocatorType of nlohmann::basic_json (see json.hpp)
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(JsonArena::allocate_current(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        JsonArena::deallocate(pointer);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) noexcept { return true; }
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) noexcept { return false; }
+
+} // namespace mcp
+
+#endif // MCP_JSON_ARENA_HPP
@@ -0,0 +1,29 @@
+#ifndef MCP_JSON_SCANNER_HPP
+#define MCP_JSON_SCANNER_HPP
+
+#include <string_view>
+
+namespace mcp {
+
+// Raw JSON text of the members of a JSON-RPC request that routing needs,
+// located without building a document. Each view points into the scanned
+// text and is empty when the member is absent.
+struct MessageEnvelope {
+    std::string_view jsonrpc;
+    std::string_view id;
+    std::string_view method;
+    std::string_view params;
+    std::string_view arguments;   // params.arguments
+};
+
+// Validates text as a single JSON object and fills in the envelope. Uses
+// SSE2 to skip over string contents where available. Returns false for
+// malformed JSON, for batches and other non-object messages, and for
+// input it leaves to the full parser (escaped keys, repeated envelope
+// members, very deep nesting, a byte order mark); callers then fall back
+// to json::parse.
+bool scan_message(std::string_view text, MessageEnvelope& envelope);
+
+} // namespace mcp
+
+#endif // MCP_JSON_SCANNER_HPP
@@ -0,0 +1,35 @@
+#ifndef MCP_JSON_WRITER_HPP
+#define MCP_JSON_WRITER_HPP
+
+#include <string>
+#include <string_view>
+#include "json.hpp"
+
+namespace mcp {
+
+// Serializers that append to an existing buffer instead of returning a new
+// string, so a response is written once, front to back. Output matches
+// json::dump() byte for byte.
+
+// Append value as compact JSON
+void write_json(std::string& out, const json& value);
+
+// Append text as a JSON string literal, escaped as json::dump() does.
+// Invalid UTF-8 sequences are replaced with U+FFFD instead of throwing, so
+// raw text such as command output can always be sent.
+void write_json_string(std::string& out, std::string_view text);
+
+// Append value's compact serialization as a JSON string literal, escaping
+// while serializing; the same as json(value.dump()).dump() without the
+// intermediate string
+void write_json_text(std::string& out, const json& value);
+
+// Append a JSON-RPC response around an already serialized result
+void write_success_response(std::string& out, const json& id, std::string_view result);
+
+// Append a JSON-RPC error response
+void write_error_response(std::string& out, const json& id, int code, const std::string& message);
+
+} // namespace mcp
+
+#endif // MCP_JSON_WRITER_HPP
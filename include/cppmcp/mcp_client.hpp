@@ -2,12 +2,12 @@
 
 #include <string>
 #include <functional>
-#include <nlohmann/json.hpp>
+#include "json.hpp"
+#include "message_encoding.hpp"
+#include "stdio_transport.hpp"
 #include <memory>
 #include <vector>
 
-using json = nlohmann::json;
-
 namespace mcp {
 
 // Forward declarations
@@ -39,6 +39,25 @@ public:
     std::vector<Prompt> list_prompts();
     json get_prompt(const std::string& name, const json& arguments);
 
+    // Called for notifications the server sends while a request is running,
+    // e.g. notifications/progress. When set, call_tool asks for progress.
+    using NotificationHandler = std::function<void(const json& notification)>;
+    void set_notification_handler(NotificationHandler handler) { notification_handler_ = std::move(handler); }
+
+    // Request timeout for the SSE/HTTP transport in seconds (0 = none)
+    void set_timeout(long seconds) { timeout_seconds_ = seconds; }
+
+    // Message encoding for the SSE/HTTP transport. JSON by default; CBOR or
+    // MessagePack skip text escaping of large payloads, for servers that
+    // accept them (such as MCPServer)
+    void set_encoding(MessageEncoding encoding) { encoding_ = encoding; }
+
+    // Message framing for the STDIO transport, set before connecting.
+    // Newline by default; ContentLength sends LSP-style headers, which
+    // MCPServer detects and answers with the same framing. Responses are
+    // read in whichever framing the server uses.
+    void set_stdio_framing(StdioFraming framing) { stdio_framing_ = framing; }
+
     // Utility methods
     std::string get_server_name() const { return server_name_; }
     std::string get_server_version() const { return server_version_; }
@@ -57,6 +76,9 @@ private:
     
     bool connected_;
     int request_id_;
+    long timeout_seconds_;
+    MessageEncoding encoding_;
+    NotificationHandler notification_handler_;
     
     // Transport specific
     enum class TransportType { STDIO, SSE };
@@ -66,10 +88,13 @@ private:
     int process_pid_;
     int stdin_fd_;
     int stdout_fd_;
+    StdioFraming stdio_framing_;
+    std::unique_ptr<FrameReader> reader_;
     
     // SSE transport
     std::string sse_url_;
     std::string sse_endpoint_;
+    std::string session_id_;  // Mcp-Session-Id assigned on initialize
 };
 
 // Tool definition
@@ -3,33 +3,100 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <functional>
 #include <memory>
-#include <nlohmann/json.hpp>
-
-using json = nlohmann::json;
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <chrono>
+#include <exception>
+#include <string_view>
+#include <thread>
+#include "json.hpp"
+#include "request_context.hpp"
+#include "tool_result.hpp"
+#include "typed_tool.hpp"
+#include "stdio_transport.hpp"
 
 namespace mcp {
 
 // Forward declarations
 class MCPServer;
+class WorkerPool;
+class EventLoop;
+class SchemaValidator;
+struct MessageEnvelope;
 
 // Tool function signature
 using ToolFunction = std::function<json(const json& arguments)>;
 
+// Tool returning ready-made content blocks, spliced into the response as is
+using ContentToolFunction = std::function<ToolResult(const json& arguments)>;
+
 // Resource function signature
 using ResourceFunction = std::function<std::string()>;
 
 // Prompt function signature
 using PromptFunction = std::function<json(const json& arguments)>;
 
+// JSON-RPC method handler signature (receives params, returns the result)
+using MethodHandler = std::function<json(const json& params)>;
+
+// Receives the serialized response to a message (empty for notifications)
+using ResponseCallback = std::function<void(std::string response)>;
+
+// Completion handle passed to asynchronous tools. Call resolve() or
+// reject() once, from any thread; later calls are ignored. If every copy
+// is dropped without either, the call fails.
+class ToolCompletion {
+public:
+    void resolve(const json& result) const;
+    void resolve(ToolResult result) const;
+    void reject(const std::string& message) const;
+
+    // The request being completed (cancellation, deadline, progress).
+    // RequestContext::current() is only set while the tool function runs.
+    RequestContext& context() const;
+
+private:
+    friend class MCPServer;
+    struct State;
+    explicit ToolCompletion(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<State> state_;
+};
+
+// Asynchronous tool signature: starts the work and returns; the result is
+// delivered later through the completion handle, e.g. from an I/O callback.
+// arguments refers into the request and is only valid until the function
+// returns; copy what the pending work needs.
+using AsyncToolFunction = std::function<void(const json& arguments, ToolCompletion done)>;
+
+// Error carrying a JSON-RPC error code; thrown by handlers to report
+// something more specific than an internal error (-32603)
+class JsonRpcError : public std::runtime_error {
+public:
+    JsonRpcError(int code, const std::string& message)
+        : std::runtime_error(message), code_(code) {}
+
+    int code() const { return code_; }
+
+private:
+    int code_;
+};
+
 // Tool definition
 struct Tool {
     std::string name;
     std::string description;
     json input_schema;
     ToolFunction function;
+    ContentToolFunction content_function;  // Set instead of function for content tools
+    AsyncToolFunction async_function;      // Set instead of function for async tools
+    std::chrono::milliseconds timeout{0};  // Execution deadline (0 = server default)
+    std::shared_ptr<const SchemaValidator> validator;  // Compiled input_schema, if it constrains anything
 };
 
 // Resource definition
@@ -39,6 +106,7 @@ struct Resource {
     std::string description;
     std::string mime_type;
     ResourceFunction function;
+    bool binary = false;  // function returns raw bytes, sent base64-encoded as blob
 };
 
 // Prompt definition
@@ -61,21 +129,158 @@ public:
     MCPServer(const std::string& name, const std::string& version = "1.0.0");
     ~MCPServer();
 
-    // Register tools, resources, and prompts
+    // Register tools, resources, and prompts. A tool's input_schema is
+    // compiled when it is registered (std::invalid_argument if malformed)
+    // and tools/call arguments are checked against it before the tool
+    // runs; calls that don't conform fail with -32602.
     void add_tool(const std::string& name, const std::string& description,
                   const json& input_schema, ToolFunction func);
+    void add_tool(const std::string& name, const std::string& description,
+                  const json& input_schema, ContentToolFunction func);
+    
+    // Register a tool taking a CPPMCP_TOOL_ARGS struct: the input schema
+    // is generated from the struct's fields, and arguments are decoded
+    // into it in one pass after validation. func returns json or a
+    // ToolResult. descriptions maps field names to their description.
+    template <typename Args, typename F>
+    void add_tool(const std::string& name, const std::string& description, F func);
+    template <typename Args, typename F>
+    void add_tool(const std::string& name, const std::string& description,
+                  const json& descriptions, F func);
+    
+    // Register a tool that completes asynchronously, so a tool waiting on
+    // I/O doesn't hold a server thread until it finishes
+    void add_async_tool(const std::string& name, const std::string& description,
+                        const json& input_schema, AsyncToolFunction func);
     
     void add_resource(const std::string& uri, const std::string& name,
                      const std::string& description, const std::string& mime_type,
                      ResourceFunction func);
     
+    // Register a binary resource (images, archives, model files); func
+    // returns raw bytes, which are base64-encoded straight into the response
+    void add_blob_resource(const std::string& uri, const std::string& name,
+                           const std::string& description, const std::string& mime_type,
+                           ResourceFunction func);
+    
     void add_prompt(const std::string& name, const std::string& description,
                    const json& arguments, PromptFunction func);
 
+    // Unregister; returns false if nothing was registered under that key
+    bool remove_tool(const std::string& name);
+    bool remove_resource(const std::string& uri);
+    bool remove_prompt(const std::string& name);
+
+    // Registrations may happen while the server is running: each one
+    // publishes a new registry version without blocking requests, and
+    // connected clients get a notifications/*/list_changed. A batch groups
+    // many registrations into a single version and notification.
+    class RegistrationBatch {
+    public:
+        explicit RegistrationBatch(MCPServer& server);
+        ~RegistrationBatch();
+
+        RegistrationBatch(const RegistrationBatch&) = delete;
+        RegistrationBatch& operator=(const RegistrationBatch&) = delete;
+
+    private:
+        MCPServer& server_;
+    };
+
+    // Register a JSON-RPC method handler (e.g. "completion/complete" or a
+    // vendor extension). Replaces any existing handler with the same name.
+    // Methods that don't require initialization may be called before
+    // "initialize" has completed.
+    void register_method(const std::string& method, MethodHandler handler,
+                         bool requires_initialization = true);
+
+    // Process a JSON-RPC message or batch and return the response
+    // (null for notifications, which must not be answered)
+    json handle_message(const json& message);
+
+    // Same as handle_message, but returns the serialized response as sent
+    // on the wire (empty for notifications). Notifications emitted while
+    // the request runs, such as progress, go to notify.
+    std::string handle_message_raw(const json& message, const NotificationSink& notify = nullptr);
+
+    // Same as handle_message_raw, but doesn't wait for asynchronous tools:
+    // on_response is called exactly once, possibly on another thread after
+    // this returns. on_response and notify must not throw.
+    void handle_message_async(const json& message, ResponseCallback on_response,
+                              NotificationSink notify = nullptr);
+
+    // Parse and handle a serialized message; throws json::exception if it
+    // isn't valid JSON. Transports use this entry point.
+    std::string handle_message_text(const std::string& text, const NotificationSink& notify = nullptr);
+
+    // Route messages from a fast scan of the JSON-RPC envelope instead of a
+    // full parse (off by default). Only the small params members are parsed
+    // up front; tools/call arguments are parsed when the tool is about to
+    // run, so rejected calls never pay for them.
+    void set_lazy_parsing(bool enabled);
+
+    // Dispatch requests to a pool of worker threads so a slow tool doesn't
+    // block other requests; responses are written as soon as they complete
+    // and matched by JSON-RPC id. 0 (the default) handles requests inline.
+    // At most max_queued requests wait for a free worker before the
+    // STDIO reader stops accepting input. Entries of a JSON-RPC batch run
+    // in parallel only with a pool, on every transport; HTTP has none by
+    // default, so batches there run one entry after another unless this
+    // is called.
+    void set_worker_threads(size_t threads, size_t max_queued = 64);
+
+    // Deadline for tools/call: per tool, or a default for tools without one
+    // (0 = none). Clients may shorten it per request with _meta.timeoutMs.
+    // Past the deadline the request is cancelled and answered with a
+    // timeout error (-32001); executors receive the remaining budget.
+    void set_tool_timeout(const std::string& name, std::chrono::milliseconds timeout);
+    void set_default_tool_timeout(std::chrono::milliseconds timeout);
+
+    // Split tools/list, resources/list and prompts/list into pages of at
+    // most page_size entries, linked by opaque cursors (0 = no paging)
+    void set_page_size(size_t page_size);
+
+    // Largest message the transports accept, in bytes, and deepest nesting
+    // of objects and arrays (0 = no limit; defaults 128 MiB and 256).
+    // Input is checked as it is read, so an oversized or too deeply nested
+    // message is rejected (-32600, or HTTP 413/400) before it is buffered
+    // or parsed in full.
+    void set_message_limits(size_t max_bytes, size_t max_depth);
+
+    // Bound on STDIO output waiting to be written (0 = none; default
+    // 16 MiB). Responses are written from the event loop; while this
+    // much is queued, e.g. because the client isn't reading, the reader
+    // stops taking new requests from stdin.
+    void set_output_queue_limit(size_t max_bytes);
+
+    // Message framing on STDIO. Auto (the default) serves both newline-
+    // delimited clients and clients that send LSP-style Content-Length
+    // headers, detected from the first message and answered in kind.
+    // Content-Length lets the server reject an oversized message without
+    // reading it and read any other in one bulk read of its exact size.
+    void set_stdio_framing(StdioFraming framing);
+
     // Run the server
     void run_stdio();
+    // Serve STDIO messages on the given file descriptors instead of
+    // stdin/stdout
+    void run_stdio(int in_fd, int out_fd);
     void run_sse(int port = 8080);
 
+    // Serve HTTP from a background thread while the caller runs STDIO or
+    // calls handle_message*; returns false if the port can't be bound.
+    // Every transport shares the registry, worker pool and event loop,
+    // and each client (a STDIO stream, an HTTP Mcp-Session-Id) has its own
+    // initialization and request state.
+    //
+    //   server.start_sse(8080);
+    //   server.run_stdio();
+    //   server.stop_sse();
+    bool start_sse(int port = 8080);
+    // Stop the HTTP server, whether started by start_sse or run_sse on
+    // another thread, and join start_sse's thread. Called by the destructor.
+    void stop_sse();
+
     // Get server info
     std::string get_name() const { return server_name_; }
     std::string get_version() const { return server_version_; }
@@ -84,36 +289,207 @@ private:
     std::string server_name_;
     std::string server_version_;
     
-    std::map<std::string, Tool> tools_;
-    std::map<std::string, Resource> resources_;
-    std::map<std::string, Prompt> prompts_;
+    // Registered tools, resources and prompts. A catalog version is never
+    // modified once published; entries keep their serialized list
+    // fragment next to the definition.
+    template <typename T>
+    struct CatalogEntry {
+        T item;
+        std::string serialized;
+    };
 
-    bool initialized_;
-    json client_info_;
+    template <typename T>
+    struct Catalog {
+        std::map<std::string, std::shared_ptr<const CatalogEntry<T>>> entries;
 
-    // Message handling
-    json handle_message(const json& message);
-    json handle_initialize(const json& params);
-    json handle_tools_list(const json& params);
-    json handle_tools_call(const json& params);
-    json handle_resources_list(const json& params);
-    json handle_resources_read(const json& params);
-    json handle_prompts_list(const json& params);
+        // Full list result, serialized once per version on first use
+        mutable std::once_flag list_once;
+        mutable std::string list;
+
+        Catalog() = default;
+        Catalog(const Catalog& other) : entries(other.entries) {}
+    };
+
+    // RCU-style registry: readers grab the current version with one atomic
+    // load and never block; writers copy the catalog they change into a
+    // pending version and publish it with an atomic store
+    struct Registry {
+        std::shared_ptr<Catalog<Tool>> tools;
+        std::shared_ptr<Catalog<Resource>> resources;
+        std::shared_ptr<Catalog<Prompt>> prompts;
+    };
+    std::shared_ptr<const Registry> registry_;
+
+    std::recursive_mutex registry_write_mutex_;
+    std::shared_ptr<Registry> pending_registry_;
+    bool pending_tools_;
+    bool pending_resources_;
+    bool pending_prompts_;
+    int batch_depth_;
+
+    std::shared_ptr<const Registry> registry_snapshot() const;
+    Registry& pending_registry();
+    Catalog<Tool>& pending_tools();
+    Catalog<Resource>& pending_resources();
+    Catalog<Prompt>& pending_prompts();
+    std::vector<std::string> publish_registry();
+    void notify_list_changed(const std::vector<std::string>& methods);
+
+    // State of one client: a STDIO stream or an HTTP session. Transports
+    // create one per client; the registry, worker pool, event loop and
+    // limits are shared by all of them.
+    struct Session {
+        std::atomic<bool> initialized{false};
+        json client_info;  // Guarded by mutex
+        // Cancellation tokens of requests currently being handled, keyed
+        // by serialized JSON-RPC id
+        std::unordered_map<std::string, std::shared_ptr<CancellationToken>> in_flight;
+        std::mutex mutex;
+    };
+
+    // Session of the handle_message* entry points
+    std::shared_ptr<Session> default_session_;
+
+    // Sinks reaching every connected client, registered by running
+    // transports. A sink with a session only hears from the server once
+    // that session is initialized; one without checks for itself.
+    struct BroadcastSink {
+        NotificationSink sink;
+        std::shared_ptr<Session> session;
+    };
+    std::mutex broadcast_mutex_;
+    std::map<int, BroadcastSink> broadcast_sinks_;
+    int next_sink_id_;
+    int add_broadcast_sink(NotificationSink sink, std::shared_ptr<Session> session = nullptr);
+    void remove_broadcast_sink(int id);
+
+    // Method registry, keyed by JSON-RPC method name. Built-in methods may
+    // use a raw handler that returns the already serialized result, or an
+    // async handler that completes later with the serialized result or the
+    // exception it failed with.
+    using RawMethodHandler = std::function<std::string(const json& params)>;
+    using MethodCompletion = std::function<void(std::string result, std::exception_ptr error)>;
+    // For methods that change the state of the client's session
+    using SessionMethodHandler = std::function<json(Session& session, const json& params)>;
+    // raw_arguments holds the unparsed tools/call arguments when the
+    // message arrived through lazy parsing
+    using AsyncMethodHandler = std::function<void(const json& params,
+                                                  std::string_view raw_arguments,
+                                                  const std::shared_ptr<RequestContext>& context,
+                                                  MethodCompletion done)>;
+    struct MethodEntry {
+        MethodHandler handler;
+        RawMethodHandler raw_handler;
+        AsyncMethodHandler async_handler;
+        SessionMethodHandler session_handler;
+        bool requires_initialization;
+    };
+    std::unordered_map<std::string, MethodEntry> methods_;
+
+    std::unique_ptr<WorkerPool> worker_pool_;
+
+    // Reactor shared by the transports: STDIO output, SSE keepalives and
+    // request deadlines. Started on first use.
+    std::unique_ptr<EventLoop> event_loop_;
+    std::once_flag event_loop_once_;
+    EventLoop& event_loop();
+
+    std::atomic<size_t> page_size_;
+    std::atomic<size_t> max_message_bytes_;
+    std::atomic<size_t> max_message_depth_;
+    std::atomic<size_t> max_queued_output_;
+    std::atomic<StdioFraming> stdio_framing_;
+    std::atomic<bool> lazy_parsing_;
+    std::atomic<std::chrono::milliseconds> default_tool_timeout_;
+
+    void register_builtin_methods();
+    void register_raw_method(const std::string& method, RawMethodHandler handler);
+    void register_async_method(const std::string& method, AsyncMethodHandler handler);
+    void register_session_method(const std::string& method, SessionMethodHandler handler);
+    void add_tool_entry(Tool tool);
+    void add_resource_entry(Resource resource);
+
+    // Message handling on behalf of a session; the handle_message* entry
+    // points use default_session_
+    void dispatch(const std::shared_ptr<Session>& session, const json& message,
+                  const ResponseCallback& on_response, const NotificationSink& notify);
+    std::string dispatch_and_wait(const std::shared_ptr<Session>& session, const json& message,
+                                  const NotificationSink& notify);
+    std::string dispatch_text(const std::shared_ptr<Session>& session, const std::string& text,
+                              const NotificationSink& notify);
+    // Answers through on_response instead of waiting; text only has to
+    // outlive the call. Malformed JSON throws.
+    void dispatch_text(const std::shared_ptr<Session>& session, const std::string& text,
+                       const ResponseCallback& on_response, const NotificationSink& notify);
+    void handle_request(const std::shared_ptr<Session>& session, const json& message,
+                        const NotificationSink& notify, const ResponseCallback& on_response,
+                        std::string_view raw_arguments = {});
+    // The envelope's views must stay valid until the synchronous part of
+    // the handler has returned
+    void handle_envelope(const std::shared_ptr<Session>& session, const MessageEnvelope& envelope,
+                         const NotificationSink& notify, const ResponseCallback& on_response);
+    void handle_batch(const std::shared_ptr<Session>& session, const json& batch,
+                      const NotificationSink& notify, const ResponseCallback& on_response);
+    std::string finish_request(const json& id, bool is_notification,
+                               const std::shared_ptr<CancellationToken>& token,
+                               const std::string& result, std::exception_ptr error);
+    json handle_cancelled(Session& session, const json& params);
+    void untrack_request(Session& session, const std::string& key,
+                         const std::shared_ptr<CancellationToken>& token);
+    json handle_initialize(Session& session, const json& params);
+    std::string handle_tools_list(const json& params);
+    void handle_tools_call(const json& params, std::string_view raw_arguments,
+                           const std::shared_ptr<RequestContext>& context, MethodCompletion done);
+    std::string handle_resources_list(const json& params);
+    std::string handle_resources_read(const json& params);
+    std::string handle_prompts_list(const json& params);
+    template <typename T>
+    std::string list_catalog(const char* key, const Catalog<T>& catalog, const json& params);
     json handle_prompts_get(const json& params);
     
     // Error responses
-    json create_error_response(int id, int code, const std::string& message);
-    json create_success_response(int id, const json& result);
+    json create_error_response(const json& id, int code, const std::string& message);
+    json create_success_response(const json& id, const json& result);
+    std::string serialize_success_response(const json& id, const std::string& result);
+    std::string serialize_error_response(const json& id, int code, const std::string& message);
 
     // STDIO transport
-    void run_stdio_loop();
-    std::string read_stdio_message();
-    void write_stdio_message(const std::string& message);
+    void run_stdio_loop(StdioTransport& transport);
 
-    // SSE transport
-    void run_sse_server(int port);
+    // SSE transport. on_bound is told whether the port could be bound,
+    // before requests are served.
+    void run_sse_server(int port, const std::function<void(bool bound)>& on_bound = nullptr);
+    std::thread sse_thread_;
+    std::mutex sse_mutex_;
+    std::function<void()> stop_sse_;  // Set while an HTTP server is listening
 };
 
+template <typename Args, typename F>
+void MCPServer::add_tool(const std::string& name, const std::string& description, F func) {
+    add_tool<Args>(name, description, json::object(), std::move(func));
+}
+
+template <typename Args, typename F>
+void MCPServer::add_tool(const std::string& name, const std::string& description,
+                         const json& descriptions, F func) {
+    json input_schema = ToolArgs<Args>::schema(descriptions);
+    if constexpr (std::is_same_v<std::invoke_result_t<const F&, const Args&>, ToolResult>) {
+        add_tool(name, description, input_schema, ContentToolFunction(
+            [func = std::move(func)](const json& arguments) {
+                Args args{};
+                ToolArgs<Args>::decode(arguments, args);
+                return func(args);
+            }));
+    } else {
+        add_tool(name, description, input_schema, ToolFunction(
+            [func = std::move(func)](const json& arguments) {
+                Args args{};
+                ToolArgs<Args>::decode(arguments, args);
+                return json(func(args));
+            }));
+    }
+}
+
 } // namespace mcp
 
 #endif // MCP_SERVER_HPP
@@ -0,0 +1,38 @@
+#ifndef MCP_MESSAGE_ENCODING_HPP
+#define MCP_MESSAGE_ENCODING_HPP
+
+#include <string>
+#include "json.hpp"
+
+namespace mcp {
+
+// Wire encodings for JSON-RPC messages over HTTP. JSON is the default;
+// the binary encodings avoid text escaping and are negotiated through the
+// Content-Type and Accept headers.
+enum class MessageEncoding {
+    JSON,         // application/json
+    CBOR,         // application/cbor
+    MessagePack   // application/msgpack
+};
+
+// MIME type sent for an encoding
+const char* content_type(MessageEncoding encoding);
+
+// Encoding named by a Content-Type header; JSON for anything else
+MessageEncoding encoding_from_content_type(const std::string& header);
+
+// Encoding an Accept header prefers: the highest q-value among JSON and
+// the binary types, the first listed on a tie; JSON if none is listed
+MessageEncoding encoding_from_accept(const std::string& header);
+
+// Throw json::exception on malformed input, and MessageLimitError for
+// input nested deeper than max_depth (0 = no limit)
+json decode_message(const std::string& body, MessageEncoding encoding, size_t max_depth = 0);
+std::string encode_message(const json& message, MessageEncoding encoding);
+// Re-encode serialized JSON without building a document; throws like
+// json::parse on malformed text
+std::string encode_message_text(const std::string& text, MessageEncoding encoding);
+
+} // namespace mcp
+
+#endif // MCP_MESSAGE_ENCODING_HPP
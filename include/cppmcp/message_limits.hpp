@@ -0,0 +1,59 @@
+#ifndef MCP_MESSAGE_LIMITS_HPP
+#define MCP_MESSAGE_LIMITS_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace mcp {
+
+// Thrown for a message over the configured size or nesting limit
+class MessageLimitError : public std::runtime_error {
+public:
+    MessageLimitError(const std::string& message, bool size_exceeded)
+        : std::runtime_error(message), size_exceeded_(size_exceeded) {}
+
+    static MessageLimitError too_large(size_t max_bytes) {
+        return MessageLimitError("Invalid Request: message exceeds " + std::to_string(max_bytes) + " bytes", true);
+    }
+    static MessageLimitError too_deep(size_t max_depth) {
+        return MessageLimitError("Invalid Request: nesting exceeds " + std::to_string(max_depth) + " levels", false);
+    }
+
+    // True for the size limit, false for the nesting limit
+    bool size_exceeded() const { return size_exceeded_; }
+
+private:
+    bool size_exceeded_;
+};
+
+// Checks a JSON text against size and nesting limits as it arrives, so
+// transports can reject a message before buffering or parsing all of it.
+// Only tracks strings and brackets; the text is validated by the parser.
+class MessageLimiter {
+public:
+    // 0 = no limit
+    MessageLimiter(size_t max_bytes, size_t max_depth);
+
+    // Account for the next part of the message; false once a limit is
+    // exceeded, after which error() describes it
+    bool feed(const char* data, size_t size);
+
+    // Check binary input, which has no brackets to track, by size only
+    bool feed_bytes(size_t size);
+
+    MessageLimitError error() const;
+
+private:
+    size_t max_bytes_;
+    size_t max_depth_;
+    size_t bytes_;
+    size_t depth_;
+    bool in_string_;
+    bool escaped_;
+    bool exceeded_;
+};
+
+} // namespace mcp
+
+#endif // MCP_MESSAGE_LIMITS_HPP
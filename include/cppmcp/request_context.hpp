@@ -0,0 +1,123 @@
+#ifndef MCP_REQUEST_CONTEXT_HPP
+#define MCP_REQUEST_CONTEXT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include "json.hpp"
+
+namespace mcp {
+
+// Cooperative cancellation flag shared between the server and a running
+// handler, optionally with a deadline. Handlers (and executors they call)
+// poll is_cancelled() and stop early; nothing is interrupted forcibly.
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // True once cancel() was called or the deadline has passed
+    bool is_cancelled() const { return cancellation_requested() || timed_out(); }
+
+    bool cancellation_requested() const { return cancelled_.load(std::memory_order_acquire); }
+    void cancel() { cancelled_.store(true, std::memory_order_release); }
+
+    // Keeps the earlier of the current and the given deadline
+    void set_deadline(Clock::time_point deadline);
+    bool has_deadline() const { return deadline_.load(std::memory_order_acquire) != kNoDeadline; }
+    bool timed_out() const { return has_deadline() && Clock::now() >= deadline(); }
+    Clock::time_point deadline() const;
+
+    // Time left before the deadline (Clock::duration::max() without one)
+    Clock::duration remaining() const;
+
+private:
+    static constexpr Clock::rep kNoDeadline = std::numeric_limits<Clock::rep>::max();
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<Clock::rep> deadline_{kNoDeadline};
+};
+
+// Delivers a serialized server-to-client notification over the transport
+// the request arrived on
+using NotificationSink = std::function<void(const std::string& notification)>;
+
+// State of the request being handled, available to tool handlers through
+// RequestContext::current() on the thread that runs them
+class RequestContext {
+public:
+    RequestContext(json id, std::shared_ptr<CancellationToken> token,
+                   json progress_token = json(), NotificationSink notify = nullptr);
+
+    const json& id() const { return id_; }
+    bool is_cancelled() const { return token_ && token_->is_cancelled(); }
+    const std::shared_ptr<CancellationToken>& cancellation_token() const { return token_; }
+
+    // Time budget left for this request; executors should bound their own
+    // waits by it so nested work shares one deadline
+    CancellationToken::Clock::duration remaining() const;
+
+    // Send notifications/progress for this request. Does nothing (and
+    // returns false) unless the client asked for progress by passing
+    // _meta.progressToken. message may carry partial output.
+    bool report_progress(double progress, double total = 0, const std::string& message = "");
+    bool wants_progress() const { return !progress_token_.is_null() && notify_ != nullptr; }
+
+    // Send an arbitrary notification to the requesting client
+    bool notify(const std::string& method, const json& params);
+
+    // Context of the request running on this thread, or nullptr
+    static RequestContext* current();
+
+    // Installs a context as current for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(RequestContext* context);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        RequestContext* previous_;
+    };
+
+private:
+    json id_;
+    std::shared_ptr<CancellationToken> token_;
+    json progress_token_;
+    NotificationSink notify_;
+};
+
+// Convenience for code that may run outside a request
+inline bool current_request_cancelled() {
+    RequestContext* context = RequestContext::current();
+    return context && context->is_cancelled();
+}
+
+// Remaining time budget of the current request, or the given fallback when
+// there is no request or no deadline
+template <typename Duration>
+Duration remaining_time(Duration fallback) {
+    RequestContext* context = RequestContext::current();
+    if (!context || !context->cancellation_token() || !context->cancellation_token()->has_deadline()) {
+        return fallback;
+    }
+    auto remaining = context->remaining();
+    if (remaining <= CancellationToken::Clock::duration::zero()) {
+        return Duration::zero();
+    }
+    return std::min(fallback, std::chrono::duration_cast<Duration>(remaining));
+}
+
+inline bool report_progress(double progress, double total = 0, const std::string& message = "") {
+    RequestContext* context = RequestContext::current();
+    return context && context->report_progress(progress, total, message);
+}
+
+} // namespace mcp
+
+#endif // MCP_REQUEST_CONTEXT_HPP
@@ -0,0 +1,72 @@
+#ifndef MCP_SCHEMA_VALIDATOR_HPP
+#define MCP_SCHEMA_VALIDATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json.hpp"
+
+namespace mcp {
+
+// JSON Schema compiled into a flat list of nodes, so checking a value is a
+// walk over precomputed type masks, bounds and property lists instead of a
+// fresh interpretation of the schema document. Supports type, enum, const,
+// properties, required, additionalProperties, items, minimum, maximum,
+// exclusiveMinimum, exclusiveMaximum, minLength, maxLength, minItems and
+// maxItems; other keywords are ignored.
+class SchemaValidator {
+public:
+    // Throws std::invalid_argument for a malformed schema, e.g. an unknown
+    // type name. A null or empty schema accepts anything.
+    explicit SchemaValidator(const json& schema);
+
+    // True if value conforms; otherwise error describes the first
+    // violation found, prefixed with its location ("a.b[2]: ...")
+    bool validate(const json& value, std::string& error) const;
+
+    // False if the schema accepts every value, so the check can be skipped
+    bool has_constraints() const;
+
+private:
+    enum TypeBits : uint8_t {
+        kNull = 1 << 0,
+        kBoolean = 1 << 1,
+        kInteger = 1 << 2,
+        kNumber = 1 << 3,  // Any number, integer or not
+        kString = 1 << 4,
+        kArray = 1 << 5,
+        kObject = 1 << 6,
+        kAnyType = 0x7F
+    };
+
+    struct Property {
+        std::string name;
+        int node;  // -1: any value
+        bool required;
+    };
+
+    struct Node {
+        uint8_t types = kAnyType;
+        std::vector<Property> properties;  // Declared ones, then required-only names
+        int additional = -1;               // Schema for other properties (-1: any)
+        bool additional_allowed = true;
+        int items = -1;
+        std::vector<json> allowed;         // enum / const
+        bool has_allowed = false;
+        double minimum = 0, maximum = 0;
+        bool has_minimum = false, has_maximum = false;
+        bool exclusive_minimum = false, exclusive_maximum = false;
+        size_t min_length = 0, max_length = SIZE_MAX;
+        size_t min_items = 0, max_items = SIZE_MAX;
+    };
+
+    int compile(const json& schema);
+    bool check(int node, const json& value, std::string& path, std::string& error) const;
+
+    std::vector<Node> nodes_;
+};
+
+} // namespace mcp
+
+#endif // MCP_SCHEMA_VALIDATOR_HPP
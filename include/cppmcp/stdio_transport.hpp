@@ -0,0 +1,159 @@
+#ifndef MCP_STDIO_TRANSPORT_HPP
+#define MCP_STDIO_TRANSPORT_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+namespace mcp {
+
+class EventLoop;
+class MessageLimiter;
+
+// How messages are delimited on a STDIO stream
+enum class StdioFraming {
+    Auto,          // Detected from the first message: a "Content-" header
+                   // selects ContentLength, anything else Newline
+    Newline,       // One message per line (the MCP default)
+    ContentLength  // LSP-style "Content-Length: N\r\n\r\n" before each body
+};
+
+// "Content-Length: N\r\n\r\n", the header put before a body of length bytes
+std::string content_length_header(size_t length);
+
+// Reads framed messages from a file descriptor through one reusable buffer.
+// With Content-Length framing the size is known before the body arrives:
+// an oversized message is skipped without being buffered, and any other
+// body is read straight into a string of exactly its size, in as few
+// reads as the pipe allows.
+class FrameReader {
+public:
+    explicit FrameReader(int fd, StdioFraming framing = StdioFraming::Auto,
+                         size_t buffer_size = 64 * 1024);
+
+    // Read the next message, checking it against the limiter. Returns
+    // false at end of input. A message over a limit is skipped and
+    // reported by throwing MessageLimitError; a malformed header block is
+    // skipped and reported with std::runtime_error.
+    bool read(std::string& message, MessageLimiter& limiter);
+
+    // True if a complete message is already buffered, so read won't block
+    bool has_buffered_message() const;
+
+    // The framing in use; Auto until the first message has been seen.
+    // Safe to call from any thread.
+    StdioFraming framing() const { return framing_; }
+
+private:
+    bool fill();
+    void detect_framing();
+    bool read_line(std::string& line, MessageLimiter& limiter);
+    bool read_content(std::string& message, MessageLimiter& limiter);
+    bool read_body(char* data, size_t size);
+
+    int fd_;
+    std::atomic<StdioFraming> framing_;
+    std::vector<char> buffer_;
+    size_t begin_;  // Unconsumed input is buffer_[begin_, end_)
+    size_t end_;
+    bool eof_;
+};
+
+// Framed messages over a pair of file descriptors, without iostreams.
+// Input is read by a FrameReader on the caller's thread. Output is handed
+// to the event loop through a lock-free queue, so a slow consumer never
+// blocks the threads producing responses; the loop sends everything
+// queued with a single writev, and when a pipe or socket is full it waits
+// for the descriptor to become writable instead of blocking in write.
+// Output uses the framing of the input.
+class StdioTransport {
+public:
+    // max_queued_bytes bounds the output waiting to be written
+    // (0 = no bound); see wait_for_capacity. A pipe or socket out_fd is
+    // made non-blocking while the transport exists.
+    StdioTransport(EventLoop& loop, int in_fd, int out_fd, StdioFraming framing = StdioFraming::Auto,
+                   size_t max_queued_bytes = 0, size_t buffer_size = 64 * 1024);
+
+    // Waits until everything queued has been written
+    ~StdioTransport();
+
+    StdioTransport(const StdioTransport&) = delete;
+    StdioTransport& operator=(const StdioTransport&) = delete;
+
+    // See FrameReader::read
+    bool read(std::string& message, MessageLimiter& limiter) { return reader_.read(message, limiter); }
+
+    // True if a complete message is already buffered, so read won't block
+    bool has_buffered_message() const { return reader_.has_buffered_message(); }
+
+    // Queue a message for writing, framed like the input (newline framing
+    // until the input's framing is known). Never blocks; safe to call from
+    // any thread.
+    void write(std::string message);
+
+    // Block while the queued output is at its bound, so the reader stops
+    // taking requests from a client that isn't reading responses
+    void wait_for_capacity();
+
+    // Hold queued messages until uncork, so they go out together. The
+    // cork is ignored once too much output is held.
+    void cork();
+    void uncork();
+
+private:
+    // Intrusive multi-producer single-consumer queue: producers swap
+    // themselves in at head_ with one atomic exchange; the loop follows
+    // next links from tail_, a consumed node that serves as the stub
+    struct Node {
+        std::string header;  // Content-Length framing only
+        std::string message;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    bool ready_to_write() const;
+    void schedule_flush();
+
+    // Loop thread only
+    void flush(bool writable);
+    void take_batch();
+    bool write_batch();
+    void release_batch();
+
+    EventLoop& loop_;
+    FrameReader reader_;
+    int out_fd_;
+    int saved_out_flags_;  // -1 if the descriptor was left as it was
+
+    std::atomic<Node*> head_;
+    Node* tail_;
+    std::atomic<size_t> queued_messages_;
+    std::atomic<size_t> queued_bytes_;
+    size_t max_queued_bytes_;
+    std::atomic<bool> corked_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> flush_scheduled_;
+
+    // Batch being written, owned by the loop thread
+    std::vector<Node*> batch_;
+    Node* batch_stub_;
+    std::vector<iovec> iov_;
+    size_t next_iov_;
+    bool out_watched_;  // Waiting for the descriptor to become writable
+    bool failed_;       // Output closed; everything queued is dropped
+    bool closing_;      // Set by the destructor's final flush
+
+    // Only used to sleep and wake; the queue itself takes no lock
+    std::mutex wake_mutex_;
+    std::condition_variable capacity_cv_;
+    std::condition_variable drained_cv_;
+    std::atomic<bool> reader_waiting_;
+    bool closed_;  // Guarded by wake_mutex_
+};
+
+} // namespace mcp
+
+#endif // MCP_STDIO_TRANSPORT_HPP
@@ -0,0 +1,49 @@
+#ifndef MCP_TOOL_RESULT_HPP
+#define MCP_TOOL_RESULT_HPP
+
+#include <string>
+#include <string_view>
+
+namespace mcp {
+
+// Tool result built from MCP content blocks. Each block is serialized into
+// the result as it is added, with a single escaping pass over text and no
+// intermediate json values, and the server splices the finished result
+// into the response as is. Use it for tools that already produce text
+// (file contents, command output, pre-rendered JSON) or binary data.
+class ToolResult {
+public:
+    ToolResult();
+
+    // Result with a single text block
+    static ToolResult text(std::string_view text);
+
+    // Text block. Invalid UTF-8 is replaced with U+FFFD.
+    ToolResult& add_text(std::string_view text);
+
+    // Image block; data is raw image bytes and is sent base64-encoded
+    ToolResult& add_image(std::string_view data, std::string_view mime_type);
+
+    // Embedded resource with text or binary (base64-encoded) contents
+    ToolResult& add_resource(std::string_view uri, std::string_view text,
+                             std::string_view mime_type = "text/plain");
+    ToolResult& add_resource_blob(std::string_view uri, std::string_view data,
+                                  std::string_view mime_type = "application/octet-stream");
+
+    // Mark the result as a tool-level failure (isError) reported to the model
+    ToolResult& set_error(bool is_error = true);
+
+    // Serialized result object; leaves this result empty
+    std::string release();
+
+private:
+    void begin_block();
+
+    std::string serialized_;  // '{"content":[' followed by the blocks so far
+    bool empty_;
+    bool is_error_;
+};
+
+} // namespace mcp
+
+#endif // MCP_TOOL_RESULT_HPP
@@ -0,0 +1,189 @@
+#ifndef MCP_TYPED_TOOL_HPP
+#define MCP_TYPED_TOOL_HPP
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "json.hpp"
+
+// Declare the fields of a tool argument struct, next to the struct (same
+// namespace), for use with MCPServer::add_tool<Args>:
+//
+//   struct ResizeArgs {
+//       std::string path;
+//       int width;
+//       std::optional<std::string> mode;
+//   };
+//   CPPMCP_TOOL_ARGS(ResizeArgs, path, width, mode)
+//
+// Field types: bool, integers, floating point, std::string, json (any
+// value), std::vector<T>, std::optional<T> (a property that may be
+// omitted) and other structs declared with CPPMCP_TOOL_ARGS (objects).
+#define CPPMCP_TOOL_ARGS(Type, ...)                                                   \
+    template <typename Visitor>                                                       \
+    void cppmcp_tool_args_fields(const Type*, Visitor&& visit) {                      \
+        using CppmcpToolArgsType = Type;                                              \
+        NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(CPPMCP_TOOL_ARGS_FIELD, __VA_ARGS__)) \
+    }
+#define CPPMCP_TOOL_ARGS_FIELD(field) visit(#field, &CppmcpToolArgsType::field);
+
+namespace mcp {
+
+template <typename Args>
+class ToolArgs;
+
+struct ToolArgsProbe {
+    template <typename Member>
+    void operator()(const char*, Member) const {}
+};
+
+// True for structs declared with CPPMCP_TOOL_ARGS
+template <typename T, typename = void>
+struct is_tool_args : std::false_type {};
+template <typename T>
+struct is_tool_args<T, std::void_t<decltype(cppmcp_tool_args_fields(static_cast<const T*>(nullptr),
+                                                                    ToolArgsProbe()))>>
+    : std::true_type {};
+
+template <typename T>
+struct is_std_vector : std::false_type {};
+template <typename T, typename A>
+struct is_std_vector<std::vector<T, A>> : std::true_type {};
+
+template <typename T>
+struct is_std_optional : std::false_type {};
+template <typename T>
+struct is_std_optional<std::optional<T>> : std::true_type {};
+
+// JSON Schema for a field type
+template <typename T>
+json tool_arg_schema() {
+    if constexpr (std::is_same_v<T, bool>) {
+        return {{"type", "boolean"}};
+    } else if constexpr (std::is_integral_v<T>) {
+        // Bounded by the field's range, so get_to never truncates
+        return {{"type", "integer"},
+                {"minimum", std::numeric_limits<T>::min()},
+                {"maximum", std::numeric_limits<T>::max()}};
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return {{"type", "number"}};
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return {{"type", "string"}};
+    } else if constexpr (std::is_same_v<T, json>) {
+        return json::object();
+    } else if constexpr (is_std_optional<T>::value) {
+        return tool_arg_schema<typename T::value_type>();
+    } else if constexpr (is_std_vector<T>::value) {
+        return {{"type", "array"}, {"items", tool_arg_schema<typename T::value_type>()}};
+    } else {
+        static_assert(is_tool_args<T>::value, "tool argument fields must be JSON scalars, strings, "
+                                              "vectors, optionals or CPPMCP_TOOL_ARGS structs");
+        return ToolArgs<T>::schema();
+    }
+}
+
+// Decode a value already checked against tool_arg_schema<T>()
+template <typename T>
+void decode_tool_arg(const json& value, T& out) {
+    if constexpr (is_std_optional<T>::value) {
+        if (value.is_null()) {
+            out.reset();
+        } else {
+            decode_tool_arg(value, out.emplace());
+        }
+    } else if constexpr (is_std_vector<T>::value) {
+        out.clear();
+        out.reserve(value.size());
+        for (const auto& element : value) {
+            typename T::value_type item{};
+            decode_tool_arg(element, item);
+            out.push_back(std::move(item));
+        }
+    } else if constexpr (is_tool_args<T>::value) {
+        ToolArgs<T>::decode(value, out);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        out = value.template get_ref<const std::string&>();
+    } else {
+        value.get_to(out);
+    }
+}
+
+// Schema and decoder for a CPPMCP_TOOL_ARGS struct, built once per type
+template <typename Args>
+class ToolArgs {
+public:
+    // Object schema with every field a property, required unless it is a
+    // std::optional. descriptions maps field names to their description.
+    static json schema(const json& descriptions = json::object()) {
+        json properties = json::object();
+        json required = json::array();
+        cppmcp_tool_args_fields(static_cast<const Args*>(nullptr), [&](const char* name, auto member) {
+            using Field = std::decay_t<decltype(std::declval<Args&>().*member)>;
+            json property = tool_arg_schema<Field>();
+            if (descriptions.contains(name)) {
+                property["description"] = descriptions[name];
+            }
+            properties[name] = std::move(property);
+            if (!is_std_optional<Field>::value) {
+                required.push_back(name);
+            }
+        });
+
+        json schema = {{"type", "object"}, {"properties", std::move(properties)}};
+        if (!required.empty()) {
+            schema["required"] = std::move(required);
+        }
+        return schema;
+    }
+
+    // Fill args from a validated arguments object in a single pass: object
+    // members and fields are both visited in key order and merged, so no
+    // member is looked up by name. Members that aren't fields are skipped.
+    static void decode(const json& arguments, Args& args) {
+        if (!arguments.is_object()) {
+            return;
+        }
+        const std::vector<Field>& sorted = fields();
+        auto field = sorted.begin();
+        for (auto it = arguments.begin(); it != arguments.end() && field != sorted.end(); ++it) {
+            const std::string& key = it.key();
+            while (field != sorted.end() && field->name < key) {
+                ++field;
+            }
+            if (field != sorted.end() && field->name == key) {
+                field->decode(it.value(), args);
+                ++field;
+            }
+        }
+    }
+
+private:
+    struct Field {
+        std::string name;
+        std::function<void(const json&, Args&)> decode;
+    };
+
+    // Sorted like the keys of a json object
+    static const std::vector<Field>& fields() {
+        static const std::vector<Field> sorted = [] {
+            std::vector<Field> list;
+            cppmcp_tool_args_fields(static_cast<const Args*>(nullptr), [&](const char* name, auto member) {
+                list.push_back({name, [member](const json& value, Args& args) {
+                    decode_tool_arg(value, args.*member);
+                }});
+            });
+            std::sort(list.begin(), list.end(),
+                      [](const Field& a, const Field& b) { return a.name < b.name; });
+            return list;
+        }();
+        return sorted;
+    }
+};
+
+} // namespace mcp
+
+#endif // MCP_TYPED_TOOL_HPP
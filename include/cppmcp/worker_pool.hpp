@@ -0,0 +1,58 @@
+#ifndef MCP_WORKER_POOL_HPP
+#define MCP_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcp {
+
+// Fixed-size thread pool with a bounded task queue.
+// submit() blocks while the queue is full, which throttles producers
+// (e.g. the STDIO reader) instead of letting the backlog grow unbounded.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threads, size_t max_queued = 64);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Queue a task, waiting for space if the queue is full
+    void submit(std::function<void()> task);
+
+    // Queue a task unless the queue is full
+    bool try_submit(std::function<void()> task);
+
+    // Block until the queue is empty and no task is running
+    void wait_idle();
+
+    // Run body(0..count-1) across the pool and wait for all of them.
+    // The calling thread takes part, so this is safe to call from a
+    // worker and never waits on tasks stuck behind it in the queue.
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    size_t max_queued_;
+    size_t active_;
+    bool stopping_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable space_cv_;
+    std::condition_variable idle_cv_;
+};
+
+} // namespace mcp
+
+#endif // MCP_WORKER_POOL_HPP
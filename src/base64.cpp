@@ -0,0 +1,133 @@
+#include <cppmcp/base64.hpp>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CPPMCP_BASE64_SSE2 1
+#endif
+
+namespace mcp {
+
+static const char kEncodeTable[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int decode_char(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+#ifdef CPPMCP_BASE64_SSE2
+// Encode 12 input bytes into 16 characters. Each 32-bit lane holds one
+// 3-byte group and is split into four 6-bit indices, one per byte, which
+// are mapped to characters by adding a per-range offset.
+static inline void encode12(const uint8_t* in, char* out) {
+    auto group = [in](int i) {
+        const uint8_t* p = in + i * 3;
+        return static_cast<int>((uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2]);
+    };
+    __m128i n = _mm_set_epi32(group(3), group(2), group(1), group(0));
+
+    const __m128i six = _mm_set1_epi32(0x3F);
+    __m128i indices = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(n, 18), six),
+                     _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(n, 12), six), 8)),
+        _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(n, 6), six), 16),
+                     _mm_slli_epi32(_mm_and_si128(n, six), 24)));
+
+    // 'A' for 0-25, 'a' - 26 from 26, '0' - 52 from 52, '+' - 62 at 62,
+    // '/' - 63 at 63; each range adds the difference to the previous offset
+    __m128i offset = _mm_set1_epi8('A');
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(25)),
+                                                _mm_set1_epi8(('a' - 26) - 'A')));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(51)),
+                                                _mm_set1_epi8(('0' - 52) - ('a' - 26))));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(61)),
+                                                _mm_set1_epi8(('+' - 62) - ('0' - 52))));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(62)),
+                                                _mm_set1_epi8(('/' - 63) - ('+' - 62))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi8(indices, offset));
+}
+#endif
+
+void base64_encode_append(std::string& out, const void* data, size_t size) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    size_t start = out.size();
+    out.resize(start + (size + 2) / 3 * 4);
+    char* dst = &out[start];
+    
+    size_t i = 0;
+#ifdef CPPMCP_BASE64_SSE2
+    for (; i + 12 <= size; i += 12) {
+        encode12(in + i, dst);
+        dst += 16;
+    }
+#endif
+    for (; i + 3 <= size; i += 3) {
+        uint32_t n = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+        dst[0] = kEncodeTable[(n >> 18) & 0x3F];
+        dst[1] = kEncodeTable[(n >> 12) & 0x3F];
+        dst[2] = kEncodeTable[(n >> 6) & 0x3F];
+        dst[3] = kEncodeTable[n & 0x3F];
+        dst += 4;
+    }
+    
+    if (i < size) {
+        uint32_t n = uint32_t(in[i]) << 16;
+        if (i + 1 < size) {
+            n |= uint32_t(in[i + 1]) << 8;
+        }
+        dst[0] = kEncodeTable[(n >> 18) & 0x3F];
+        dst[1] = kEncodeTable[(n >> 12) & 0x3F];
+        dst[2] = (i + 1 < size) ? kEncodeTable[(n >> 6) & 0x3F] : '=';
+        dst[3] = '=';
+    }
+}
+
+std::string base64_encode(const void* data, size_t size) {
+    std::string out;
+    base64_encode_append(out, data, size);
+    return out;
+}
+
+std::string base64_encode(const std::string& data) {
+    return base64_encode(data.data(), data.size());
+}
+
+bool base64_decode(const std::string& encoded, std::string& decoded) {
+    if (encoded.size() % 4 != 0) {
+        return false;
+    }
+    
+    decoded.clear();
+    decoded.reserve(encoded.size() / 4 * 3);
+    
+    for (size_t i = 0; i < encoded.size(); i += 4) {
+        int a = decode_char(encoded[i]);
+        int b = decode_char(encoded[i + 1]);
+        if (a < 0 || b < 0) {
+            return false;
+        }
+        
+        bool last = i + 4 == encoded.size();
+        bool pad2 = last && encoded[i + 2] == '=';
+        bool pad3 = last && encoded[i + 3] == '=';
+        int c = pad2 ? 0 : decode_char(encoded[i + 2]);
+        int d = pad3 ? 0 : decode_char(encoded[i + 3]);
+        if (c < 0 || d < 0 || (pad2 && !pad3)) {
+            return false;
+        }
+        
+        uint32_t n = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+        decoded += char((n >> 16) & 0xFF);
+        if (!pad2) decoded += char((n >> 8) & 0xFF);
+        if (!pad3) decoded += char(n & 0xFF);
+    }
+    
+    return true;
+}
+
+} // namespace mcp
@@ -8,7 +8,14 @@
 #include <memory>
 #include <regex>
 #include <set>
+#include <chrono>
 #include <curl/curl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <signal.h>
+#include <sys/wait.h>
 
 namespace dynamic_mcp {
 
@@ -19,18 +26,42 @@ static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::stri
     return size * nmemb;
 }
 
-bool validate_parameter_type(const std::string& type_str, const json& value) {
+// Aborts the transfer once the calling request has been cancelled
+static int CancelCallback(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    auto* context = static_cast<mcp::RequestContext*>(clientp);
+    return context && context->is_cancelled() ? 1 : 0;
+}
+
+// JSON Schema type of a config parameter type. Empty for types the config
+// format doesn't define, which accept any value.
+static std::string schema_type(const std::string& type_str) {
     if (type_str == "string" || type_str == "str") {
-        return value.is_string();
+        return "string";
     } else if (type_str == "integer" || type_str == "int") {
-        return value.is_number_integer();
+        return "integer";
     } else if (type_str == "float" || type_str == "double" || type_str == "number") {
-        return value.is_number();
+        return "number";
     } else if (type_str == "boolean" || type_str == "bool") {
+        return "boolean";
+    } else if (type_str == "object" || type_str == "array") {
+        return type_str;
+    }
+    return std::string();
+}
+
+bool validate_parameter_type(const std::string& type_str, const json& value) {
+    std::string type = schema_type(type_str);
+    if (type == "string") {
+        return value.is_string();
+    } else if (type == "integer") {
+        return value.is_number_integer();
+    } else if (type == "number") {
+        return value.is_number();
+    } else if (type == "boolean") {
         return value.is_boolean();
-    } else if (type_str == "object") {
+    } else if (type == "object") {
         return value.is_object();
-    } else if (type_str == "array") {
+    } else if (type == "array") {
         return value.is_array();
     }
     return true; // Allow any type if not specified
@@ -43,6 +74,43 @@ json create_error_response(const std::string& error_message) {
     };
 }
 
+// Input schema for task/workflow parameters. The server compiles it when
+// the tool is registered and rejects calls with missing or mistyped
+// arguments (-32602) before they reach an executor.
+static json build_input_schema(const std::vector<TaskParameter>& parameters) {
+    json properties = json::object();
+    json required = json::array();
+    
+    for (const auto& param : parameters) {
+        json param_schema = {
+            {"description", param.description}
+        };
+        
+        // Same mapping validate_parameter_type checks against; types it
+        // doesn't know stay unconstrained
+        std::string type = schema_type(param.type);
+        if (!type.empty()) {
+            param_schema["type"] = type;
+        }
+        
+        properties[param.name] = param_schema;
+        
+        if (param.required && param.default_value.is_null()) {
+            required.push_back(param.name);
+        }
+    }
+    
+    json input_schema = {
+        {"type", "object"},
+        {"properties", properties}
+    };
+    
+    if (!required.empty()) {
+        input_schema["required"] = required;
+    }
+    return input_schema;
+}
+
 json create_success_response(const json& data) {
     json response = {{"success", true}};
     if (!data.is_null()) {
@@ -175,7 +243,18 @@ json RestApiExecutor::execute(const json& task_config, const json& params) {
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+        
+        // Configured timeout, capped by what is left of the request's deadline
+        auto timeout = mcp::remaining_time(std::chrono::milliseconds(
+            static_cast<long>(task_config.value("timeout", 30.0) * 1000)));
+        if (timeout.count() <= 0) {
+            curl_easy_cleanup(curl);
+            return create_error_response("REST API request timed out before it started");
+        }
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CancelCallback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, mcp::RequestContext::current());
         
         // Set headers
         struct curl_slist* curl_headers = nullptr;
@@ -213,6 +292,15 @@ json RestApiExecutor::execute(const json& task_config, const json& params) {
         }
         curl_easy_cleanup(curl);
         
+        if (res == CURLE_ABORTED_BY_CALLBACK || res == CURLE_OPERATION_TIMEDOUT) {
+            auto* context = mcp::RequestContext::current();
+            bool timed_out = res == CURLE_OPERATION_TIMEDOUT ||
+                             (context && context->cancellation_token() &&
+                              context->cancellation_token()->timed_out());
+            return create_error_response(timed_out ? "REST API request timed out"
+                                                   : "REST API request cancelled");
+        }
+        
         if (res != CURLE_OK) {
             return create_error_response(std::string("CURL error: ") + curl_easy_strerror(res));
         }
@@ -243,7 +331,7 @@ json RestApiExecutor::execute(const json& task_config, const json& params) {
 json TerminalExecutor::execute(const json& task_config, const json& params) {
     try {
         std::string command = task_config.value("command", "");
-        int timeout = task_config.value("timeout", 30);
+        double timeout_seconds = task_config.value("timeout", 30.0);
         
         // Replace parameters in command
         for (auto& [key, value] : params.items()) {
@@ -258,20 +346,93 @@ json TerminalExecutor::execute(const json& task_config, const json& params) {
         
         std::cerr << "💻 Executing: " << command << std::endl;
         
-        // Execute command and capture output
-        std::array<char, 128> buffer;
-        std::string result;
-        std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
+        // Run through the shell in its own process group so cancellation
+        // can kill the whole pipeline, not just the shell. The pipe is
+        // close-on-exec so commands forked concurrently by other workers
+        // don't inherit its write end and hold off our EOF.
+        int out_pipe[2];
+        if (pipe2(out_pipe, O_CLOEXEC) < 0) {
+            return create_error_response("Failed to execute command");
+        }
         
-        if (!pipe) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(out_pipe[0]);
+            close(out_pipe[1]);
             return create_error_response("Failed to execute command");
         }
         
-        while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-            result += buffer.data();
+        if (pid == 0) {
+            setpgid(0, 0);
+            dup2(out_pipe[1], STDOUT_FILENO);
+            close(out_pipe[0]);
+            close(out_pipe[1]);
+            execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
         }
         
-        int returncode = pclose(pipe.release()) / 256;
+        // Also set from here, so a kill can't reach the group before the
+        // child has created it; whichever call comes second is a no-op
+        setpgid(pid, pid);
+        close(out_pipe[1]);
+        
+        // Configured timeout, capped by what is left of the request's deadline
+        auto timeout = mcp::remaining_time(std::chrono::milliseconds(
+            static_cast<long>(timeout_seconds * 1000)));
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        
+        // Capture output, checking for cancellation and timeout between reads
+        std::array<char, 4096> buffer;
+        std::string result;
+        bool cancelled = false;
+        bool timed_out = false;
+        
+        while (true) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                timed_out = true;
+            } else if (mcp::current_request_cancelled()) {
+                cancelled = true;
+            }
+            if (timed_out || cancelled) {
+                kill(-pid, SIGKILL);
+                break;
+            }
+            
+            struct pollfd pfd = {out_pipe[0], POLLIN, 0};
+            int ready = poll(&pfd, 1, 100);
+            if (ready < 0 && errno != EINTR) {
+                break;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+            
+            ssize_t n = read(out_pipe[0], buffer.data(), buffer.size());
+            if (n > 0) {
+                result.append(buffer.data(), n);
+                
+                // Stream output as it arrives when the client asked for progress
+                mcp::report_progress(static_cast<double>(result.size()), 0, std::string(buffer.data(), n));
+            } else if (n == 0 || errno != EINTR) {
+                break;
+            }
+        }
+        
+        close(out_pipe[0]);
+        
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        
+        if (timed_out) {
+            return create_error_response("Command timed out after " +
+                                         std::to_string(timeout.count()) + " ms: " + command);
+        }
+        if (cancelled) {
+            return create_error_response("Command cancelled: " + command);
+        }
+        
+        int returncode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
         
         return {
             {"success", returncode == 0},
@@ -301,20 +462,35 @@ json FileOperationExecutor::execute(const json& task_config, const json& params)
         std::string file_path = params["file_path"];
         
         if (action == "read") {
-            std::ifstream file(file_path);
+            std::ifstream file(file_path, std::ios::binary | std::ios::ate);
             if (!file.is_open()) {
                 return create_error_response("File not found: " + file_path);
             }
             
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string content = buffer.str();
+            // Read in chunks so large files report progress and can be cancelled
+            std::streamsize total = file.tellg();
+            file.seekg(0);
+            std::string content;
+            if (total > 0) {
+                content.reserve(static_cast<size_t>(total));
+            }
+            
+            const size_t chunk_size = 1 << 20;
+            std::vector<char> chunk(chunk_size);
+            while (file.read(chunk.data(), chunk_size) || file.gcount() > 0) {
+                content.append(chunk.data(), static_cast<size_t>(file.gcount()));
+                if (mcp::current_request_cancelled()) {
+                    return create_error_response("File read cancelled: " + file_path);
+                }
+                mcp::report_progress(static_cast<double>(content.size()), static_cast<double>(total));
+            }
             
+            size_t size = content.size();
             return {
                 {"success", true},
-                {"content", content},
+                {"content", std::move(content)},
                 {"file_path", file_path},
-                {"size", content.size()}
+                {"size", size}
             };
         }
         else if (action == "write") {
@@ -322,7 +498,7 @@ json FileOperationExecutor::execute(const json& task_config, const json& params)
                 return create_error_response("content is required for write operation");
             }
             
-            std::string content = params["content"];
+            const std::string& content = params["content"].get_ref<const std::string&>();
             
             // TODO: Create directories if needed
             
@@ -345,7 +521,7 @@ json FileOperationExecutor::execute(const json& task_config, const json& params)
                 return create_error_response("content is required for append operation");
             }
             
-            std::string content = params["content"];
+            const std::string& content = params["content"].get_ref<const std::string&>();
             
             std::ofstream file(file_path, std::ios::app);
             if (!file.is_open()) {
@@ -380,12 +556,12 @@ json DataProcessingExecutor::execute(const json& task_config, const json& params
                 return create_error_response("json_string is required");
             }
             
-            std::string json_string = params["json_string"];
+            const std::string& json_string = params["json_string"].get_ref<const std::string&>();
             json parsed = json::parse(json_string);
             
             return {
                 {"success", true},
-                {"data", parsed},
+                {"data", std::move(parsed)},
                 {"processor", processor}
             };
         }
@@ -394,33 +570,47 @@ json DataProcessingExecutor::execute(const json& task_config, const json& params
                 return create_error_response("csv_data is required");
             }
             
-            std::string csv_data = params["csv_data"];
+            // Parsed in place; the input may be many megabytes
+            const std::string& csv_data = params["csv_data"].get_ref<const std::string&>();
             std::string operation = params.value("operation", "parse");
             std::string delimiter = task_config.value("delimiter", ",");
             
             // Simple CSV parsing
             std::vector<std::vector<std::string>> rows;
-            std::istringstream stream(csv_data);
-            std::string line;
+            auto data_end = csv_data.end();
+            auto line_begin = csv_data.begin();
             
-            while (std::getline(stream, line)) {
-                std::vector<std::string> row;
-                std::istringstream line_stream(line);
-                std::string cell;
+            while (line_begin != data_end) {
+                if (rows.size() % 10000 == 0 && !rows.empty()) {
+                    if (mcp::current_request_cancelled()) {
+                        return create_error_response("CSV processing cancelled");
+                    }
+                    mcp::report_progress(static_cast<double>(line_begin - csv_data.begin()),
+                                         static_cast<double>(csv_data.size()));
+                }
+                
+                auto line_end = std::find(line_begin, data_end, '\n');
                 
-                while (std::getline(line_stream, cell, delimiter[0])) {
-                    row.push_back(cell);
+                // Same splitting as std::getline: no cell after a trailing delimiter
+                std::vector<std::string> row;
+                for (auto cell_begin = line_begin; cell_begin != line_end;) {
+                    auto cell_end = std::find(cell_begin, line_end, delimiter[0]);
+                    row.emplace_back(cell_begin, cell_end);
+                    cell_begin = cell_end == line_end ? line_end : cell_end + 1;
                 }
                 
                 if (!row.empty()) {
-                    rows.push_back(row);
+                    rows.push_back(std::move(row));
                 }
+                
+                line_begin = line_end == data_end ? data_end : line_end + 1;
             }
             
+            size_t row_count = rows.size();
             return {
                 {"success", true},
-                {"rows", rows},
-                {"row_count", rows.size()},
+                {"rows", std::move(rows)},
+                {"row_count", row_count},
                 {"processor", processor},
                 {"operation", operation}
             };
@@ -614,7 +804,15 @@ json WorkflowExecutor::execute(const WorkflowConfig& workflow, const json& param
         
         std::cerr << "🔄 Executing workflow: " << workflow.name << std::endl;
         
+        size_t completed = 0;
         for (const auto& step_name : execution_order) {
+            if (mcp::current_request_cancelled()) {
+                return create_error_response("Workflow cancelled before step: " + step_name);
+            }
+            mcp::report_progress(static_cast<double>(completed++),
+                                 static_cast<double>(execution_order.size()),
+                                 "Executing step: " + step_name);
+            
             // Find the step
             auto step_it = std::find_if(workflow.steps.begin(), workflow.steps.end(),
                 [&step_name](const WorkflowStep& s) { return s.name == step_name; });
@@ -625,13 +823,18 @@ json WorkflowExecutor::execute(const WorkflowConfig& workflow, const json& param
             
             const WorkflowStep& step = *step_it;
             
-            // Prepare step parameters
-            json step_params = params;
+            // Prepare step parameters; the workflow's own arguments are only
+            // copied when the step maps extra inputs onto them
+            const json* step_params = &params;
+            json mapped_params;
             
             // Apply input mapping
-            for (const auto& [param_name, mapping_value] : step.input_mapping) {
-                json mapped_value = replace_variables(mapping_value, step_results);
-                step_params[param_name] = mapped_value;
+            if (!step.input_mapping.empty()) {
+                mapped_params = params;
+                for (const auto& [param_name, mapping_value] : step.input_mapping) {
+                    mapped_params[param_name] = replace_variables(mapping_value, step_results);
+                }
+                step_params = &mapped_params;
             }
             
             // Execute the task
@@ -641,7 +844,7 @@ json WorkflowExecutor::execute(const WorkflowConfig& workflow, const json& param
             }
             
             std::cerr << "  ▶ Executing step: " << step_name << " (task: " << step.task << ")" << std::endl;
-            json result = task_it->second(step_params);
+            json result = task_it->second(*step_params);
             
             // Store results with output mapping
             for (const auto& [result_key, mapped_name] : step.output_mapping) {
@@ -650,16 +853,19 @@ json WorkflowExecutor::execute(const WorkflowConfig& workflow, const json& param
                 }
             }
             
+            // Check for failure
+            bool failed = result.contains("success") && !result["success"].get<bool>();
+            std::string error = failed ? result.value("error", "Unknown error") : std::string();
+            
             // Store the full result
-            step_results[step_name] = result;
+            step_results[step_name] = std::move(result);
             
-            // Check for failure
-            if (result.contains("success") && !result["success"].get<bool>()) {
+            if (failed) {
                 return {
                     {"success", false},
                     {"failed_step", step_name},
-                    {"error", result.value("error", "Unknown error")},
-                    {"step_results", step_results}
+                    {"error", error},
+                    {"step_results", std::move(step_results)}
                 };
             }
         }
@@ -668,7 +874,7 @@ json WorkflowExecutor::execute(const WorkflowConfig& workflow, const json& param
             {"success", true},
             {"workflow", workflow.name},
             {"steps_executed", execution_order.size()},
-            {"step_results", step_results}
+            {"step_results", std::move(step_results)}
         };
         
     } catch (const std::exception& e) {
@@ -742,6 +948,9 @@ DynamicToolGenerator::DynamicToolGenerator(const ConfigLoader& config_loader)
 }
 
 void DynamicToolGenerator::generate_all_tools(MCPServer& server) {
+    // Publish all generated tools as one registry version
+    MCPServer::RegistrationBatch batch(server);
+    
     // Generate task tools
     for (const auto& task : config_loader_.get_tasks()) {
         create_task_tool(server, task);
@@ -758,14 +967,20 @@ void DynamicToolGenerator::create_task_tool(MCPServer& server, const TaskConfig&
     auto handler = [this, task](const json& arguments) -> json {
         std::cerr << "🔧 Executing task: " << task.name << std::endl;
         
-        // Validate and prepare parameters
-        json params = arguments;
+        // Validate and prepare parameters. Arguments are passed through
+        // as-is and only copied when a default has to be filled in.
+        const json* params = &arguments;
+        json with_defaults;
         
         // Apply defaults for missing parameters
         for (const auto& param : task.parameters) {
-            if (!params.contains(param.name)) {
+            if (!arguments.contains(param.name)) {
                 if (!param.default_value.is_null()) {
-                    params[param.name] = param.default_value;
+                    if (params != &with_defaults) {
+                        with_defaults = arguments.is_object() ? arguments : json::object();
+                        params = &with_defaults;
+                    }
+                    with_defaults[param.name] = param.default_value;
                 } else if (param.required) {
                     return create_error_response("Missing required parameter: " + param.name);
                 }
@@ -779,57 +994,17 @@ void DynamicToolGenerator::create_task_tool(MCPServer& server, const TaskConfig&
         }
         
         // Execute
-        return exec_it->second->execute(task.config, params);
+        return exec_it->second->execute(task.config, *params);
     };
     
     // Store in registry for workflows
     task_registry_[task.name] = handler;
     
-    // Build input schema
-    json properties = json::object();
-    json required = json::array();
-    
-    for (const auto& param : task.parameters) {
-        json param_schema = {
-            {"description", param.description}
-        };
-        
-        // Map type
-        if (param.type == "integer" || param.type == "int") {
-            param_schema["type"] = "number";
-        } else if (param.type == "float" || param.type == "double" || param.type == "number") {
-            param_schema["type"] = "number";
-        } else if (param.type == "boolean" || param.type == "bool") {
-            param_schema["type"] = "boolean";
-        } else if (param.type == "object") {
-            param_schema["type"] = "object";
-        } else if (param.type == "array") {
-            param_schema["type"] = "array";
-        } else {
-            param_schema["type"] = "string";
-        }
-        
-        properties[param.name] = param_schema;
-        
-        if (param.required && param.default_value.is_null()) {
-            required.push_back(param.name);
-        }
-    }
-    
-    json input_schema = {
-        {"type", "object"},
-        {"properties", properties}
-    };
-    
-    if (!required.empty()) {
-        input_schema["required"] = required;
-    }
-    
     // Register tool
     server.add_tool(
         task.name,
         task.description + " [Operation: " + task.operation_type + "]",
-        input_schema,
+        build_input_schema(task.parameters),
         handler
     );
     
@@ -846,47 +1021,11 @@ void DynamicToolGenerator::create_workflow_tool(MCPServer& server, const Workflo
         return workflow_executor->execute(workflow, arguments);
     };
     
-    // Build input schema
-    json properties = json::object();
-    json required = json::array();
-    
-    for (const auto& param : workflow.parameters) {
-        json param_schema = {
-            {"description", param.description}
-        };
-        
-        // Map type (same as task parameters)
-        if (param.type == "integer" || param.type == "int") {
-            param_schema["type"] = "number";
-        } else if (param.type == "float" || param.type == "double" || param.type == "number") {
-            param_schema["type"] = "number";
-        } else if (param.type == "boolean" || param.type == "bool") {
-            param_schema["type"] = "boolean";
-        } else {
-            param_schema["type"] = "string";
-        }
-        
-        properties[param.name] = param_schema;
-        
-        if (param.required && param.default_value.is_null()) {
-            required.push_back(param.name);
-        }
-    }
-    
-    json input_schema = {
-        {"type", "object"},
-        {"properties", properties}
-    };
-    
-    if (!required.empty()) {
-        input_schema["required"] = required;
-    }
-    
     // Register tool
     server.add_tool(
         workflow.name,
         workflow.description + " [Workflow with " + std::to_string(workflow.steps.size()) + " steps]",
-        input_schema,
+        build_input_schema(workflow.parameters),
         handler
     );
     
@@ -0,0 +1,239 @@
+#include <cppmcp/event_loop.hpp>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace mcp {
+
+// Events handled per epoll_wait
+static const int kMaxEvents = 64;
+
+EventLoop::EventLoop() : stopping_(false), next_timer_id_(1) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        int error = errno;
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+        throw std::runtime_error(std::string("Failed to create event loop: ") + std::strerror(error));
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    thread_ = std::thread([this] { run(); });
+}
+
+EventLoop::~EventLoop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake();
+    thread_.join();
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+    (void)written;  // Only fails when the counter is already nonzero
+}
+
+void EventLoop::post(Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_.push_back(std::move(callback));
+    }
+    wake();
+}
+
+EventLoop::TimerId EventLoop::add_timer(Clock::duration delay, Callback callback) {
+    return add_timer_at(Clock::now() + delay, std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::add_timer_at(Clock::time_point when, Callback callback) {
+    TimerId id;
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_timer_id_++;
+        earliest = timers_.empty() || when < timers_.top().when;
+        timers_.push({when, id});
+        timer_callbacks_.emplace(id, std::move(callback));
+    }
+    // Only a new earliest deadline shortens the current wait
+    if (earliest && !in_loop_thread()) {
+        wake();
+    }
+    return id;
+}
+
+void EventLoop::cancel_timer(TimerId id) {
+    // The heap entry stays until its time and is skipped then
+    Callback callback;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timer_callbacks_.find(id);
+    if (it != timer_callbacks_.end()) {
+        callback = std::move(it->second);
+        timer_callbacks_.erase(it);
+    }
+}
+
+bool EventLoop::watch(int fd, uint32_t events, FdCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        watches_[fd] = std::make_shared<FdCallback>(std::move(callback));
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        watches_.erase(fd);
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::unwatch(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (watches_.erase(fd) == 0) {
+            return;
+        }
+    }
+    if (in_loop_thread()) {
+        return;
+    }
+
+    // A callback taken before the erase may still be running; once a
+    // callback posted now has run, it has returned
+    call([] {});
+}
+
+void EventLoop::call(const Callback& callback) {
+    if (in_loop_thread()) {
+        callback();
+        return;
+    }
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+    post([&] {
+        callback();
+        std::lock_guard<std::mutex> lock(done_mutex);
+        done = true;
+        done_cv.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&done] { return done; });
+}
+
+int EventLoop::wait_timeout_ms() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!posted_.empty()) {
+        return 0;
+    }
+    while (!timers_.empty() && timer_callbacks_.count(timers_.top().id) == 0) {
+        timers_.pop();
+    }
+    if (timers_.empty()) {
+        return -1;
+    }
+
+    // Rounded up, so a timer never fires before its time
+    auto remaining = timers_.top().when - Clock::now();
+    if (remaining <= Clock::duration::zero()) {
+        return 0;
+    }
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+    return ms > INT32_MAX ? INT32_MAX : static_cast<int>(ms);
+}
+
+void EventLoop::run_timers() {
+    Clock::time_point now = Clock::now();
+    while (true) {
+        Callback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (timers_.empty() || timers_.top().when > now) {
+                return;
+            }
+            TimerId id = timers_.top().id;
+            timers_.pop();
+            auto it = timer_callbacks_.find(id);
+            if (it == timer_callbacks_.end()) {
+                continue;  // Cancelled
+            }
+            callback = std::move(it->second);
+            timer_callbacks_.erase(it);
+        }
+        callback();
+    }
+}
+
+void EventLoop::run_posted() {
+    // Only what was posted so far; callbacks posting more run next round
+    std::deque<Callback> posted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted.swap(posted_);
+    }
+    for (Callback& callback : posted) {
+        callback();
+    }
+}
+
+void EventLoop::run() {
+    epoll_event events[kMaxEvents];
+    while (true) {
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, wait_timeout_ms());
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                uint64_t value;
+                ssize_t drained = ::read(wake_fd_, &value, sizeof(value));
+                (void)drained;
+                continue;
+            }
+
+            // Held by reference count, so unwatching from inside is safe
+            std::shared_ptr<FdCallback> callback;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = watches_.find(fd);
+                if (it != watches_.end()) {
+                    callback = it->second;
+                }
+            }
+            if (callback) {
+                (*callback)(events[i].events);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                break;
+            }
+        }
+        run_posted();
+        run_timers();
+    }
+}
+
+} // namespace mcp
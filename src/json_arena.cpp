@@ -0,0 +1,165 @@
+#include <cppmcp/json_arena.hpp>
+#include <cstdlib>
+
+namespace mcp {
+
+namespace {
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+constexpr size_t round_up(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+thread_local JsonArena* current_arena = nullptr;
+
+} // namespace
+
+// Chunk memory starts with this struct; allocations follow, each preceded
+// by an AllocationHeader. refs counts live allocations plus one for the
+// arena while it owns the chunk.
+struct JsonArena::Chunk {
+    std::atomic<size_t> refs;
+    size_t capacity;
+    size_t used;
+
+    unsigned char* data() {
+        return reinterpret_cast<unsigned char*>(this) + round_up(sizeof(Chunk));
+    }
+
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->~Chunk();
+            std::free(this);
+        }
+    }
+};
+
+namespace {
+
+// Owning chunk of an allocation, or nullptr for heap blocks
+struct alignas(std::max_align_t) AllocationHeader {
+    void* chunk;
+};
+
+void* allocate_heap(size_t bytes) {
+    void* memory = std::malloc(sizeof(AllocationHeader) + bytes);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    auto* header = static_cast<AllocationHeader*>(memory);
+    header->chunk = nullptr;
+    return header + 1;
+}
+
+} // namespace
+
+JsonArena::JsonArena(size_t chunk_size)
+    : chunk_size_(chunk_size), active_(0), bytes_allocated_(0) {
+}
+
+JsonArena::~JsonArena() {
+    if (current_arena == this) {
+        current_arena = nullptr;
+    }
+    for (Chunk* chunk : chunks_) {
+        chunk->release();
+    }
+}
+
+JsonArena::Chunk* JsonArena::next_chunk() {
+    // Chunks after the active one were rewound by reset()
+    if (!chunks_.empty() && active_ + 1 < chunks_.size()) {
+        return chunks_[++active_];
+    }
+
+    void* memory = std::malloc(round_up(sizeof(Chunk)) + chunk_size_);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    Chunk* chunk = new (memory) Chunk;
+    chunk->refs.store(1, std::memory_order_relaxed);
+    chunk->capacity = chunk_size_;
+    chunk->used = 0;
+
+    chunks_.push_back(chunk);
+    active_ = chunks_.size() - 1;
+    return chunk;
+}
+
+void* JsonArena::allocate(size_t bytes) {
+    size_t needed = sizeof(AllocationHeader) + round_up(bytes);
+
+    // Big blocks (e.g. growing arrays) would waste most of a chunk
+    if (needed > chunk_size_ / 4) {
+        return allocate_heap(bytes);
+    }
+
+    Chunk* chunk = chunks_.empty() ? nullptr : chunks_[active_];
+    if (!chunk || chunk->used + needed > chunk->capacity) {
+        chunk = next_chunk();
+    }
+
+    auto* header = reinterpret_cast<AllocationHeader*>(chunk->data() + chunk->used);
+    chunk->used += needed;
+    chunk->refs.fetch_add(1, std::memory_order_relaxed);
+    bytes_allocated_ += needed;
+
+    header->chunk = chunk;
+    return header + 1;
+}
+
+void JsonArena::reset() {
+    // Only this arena allocates from its chunks, so a chunk holding just
+    // the arena's reference can't gain new ones concurrently
+    size_t kept = 0;
+    for (Chunk* chunk : chunks_) {
+        if (chunk->refs.load(std::memory_order_acquire) == 1) {
+            chunk->used = 0;
+            chunks_[kept++] = chunk;
+        } else {
+            chunk->release();
+        }
+    }
+    chunks_.resize(kept);
+    active_ = 0;
+    bytes_allocated_ = 0;
+}
+
+void* JsonArena::allocate_current(size_t bytes) {
+    JsonArena* arena = current_arena;
+    return arena ? arena->allocate(bytes) : allocate_heap(bytes);
+}
+
+void JsonArena::deallocate(void* pointer) noexcept {
+    if (!pointer) {
+        return;
+    }
+
+    auto* header = static_cast<AllocationHeader*>(pointer) - 1;
+    if (header->chunk) {
+        static_cast<Chunk*>(header->chunk)->release();
+    } else {
+        std::free(header);
+    }
+}
+
+JsonArena* JsonArena::current() {
+    return current_arena;
+}
+
+JsonArena& JsonArena::thread_arena() {
+    thread_local JsonArena arena;
+    return arena;
+}
+
+JsonArena::Scope::Scope(JsonArena& arena)
+    : previous_(current_arena) {
+    current_arena = &arena;
+}
+
+JsonArena::Scope::~Scope() {
+    current_arena = previous_;
+}
+
+} // namespace mcp
@@ -0,0 +1,398 @@
+#include <cppmcp/json_scanner.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CPPMCP_SCANNER_SSE2 1
+#endif
+
+namespace mcp {
+
+namespace {
+
+// Deeper documents are left to the full parser
+constexpr int kMaxDepth = 512;
+
+// Member to capture while scanning an object; nested members are captured
+// from the member's value when it is an object
+struct Wanted {
+    const char* key;
+    std::string_view* out;
+    const Wanted* nested;
+    size_t nested_count;
+};
+
+class Scanner {
+public:
+    explicit Scanner(std::string_view text)
+        : p_(text.data()), end_(text.data() + text.size()) {}
+
+    bool document(const Wanted* wanted, size_t wanted_count) {
+        skip_whitespace();
+        if (p_ == end_ || *p_ != '{' || !object(1, wanted, wanted_count)) {
+            return false;
+        }
+        skip_whitespace();
+        return p_ == end_;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+
+    void skip_whitespace() {
+        while (p_ != end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    bool consume(char c) {
+        skip_whitespace();
+        if (p_ == end_ || *p_ != c) {
+            return false;
+        }
+        ++p_;
+        return true;
+    }
+
+    bool value(int depth) {
+        skip_whitespace();
+        if (p_ == end_) {
+            return false;
+        }
+        switch (*p_) {
+            case '{': return object(depth + 1, nullptr, 0);
+            case '[': return array(depth + 1);
+            case '"': return string();
+            case 't': return literal("true");
+            case 'f': return literal("false");
+            case 'n': return literal("null");
+            default: return number();
+        }
+    }
+
+    bool object(int depth, const Wanted* wanted, size_t wanted_count) {
+        if (depth > kMaxDepth) {
+            return false;
+        }
+        ++p_;  // '{'
+        skip_whitespace();
+        if (p_ != end_ && *p_ == '}') {
+            ++p_;
+            return true;
+        }
+
+        while (true) {
+            skip_whitespace();
+            const char* key_begin = p_;
+            if (p_ == end_ || *p_ != '"' || !string()) {
+                return false;
+            }
+            std::string_view key(key_begin + 1, static_cast<size_t>(p_ - key_begin - 2));
+            if (!consume(':')) {
+                return false;
+            }
+
+            const Wanted* match = nullptr;
+            if (wanted) {
+                // Escaped keys could spell a wanted key; leave them to the full parser
+                if (key.find('\\') != std::string_view::npos) {
+                    return false;
+                }
+                for (size_t i = 0; i < wanted_count; ++i) {
+                    if (key == wanted[i].key) {
+                        match = &wanted[i];
+                        break;
+                    }
+                }
+                // A repeated member would leave nested captures pointing
+                // into the value it replaces; the full parser keeps the last
+                if (match && !match->out->empty()) {
+                    return false;
+                }
+            }
+
+            skip_whitespace();
+            const char* value_begin = p_;
+            bool ok = match && match->nested && p_ != end_ && *p_ == '{'
+                          ? object(depth + 1, match->nested, match->nested_count)
+                          : value(depth);
+            if (!ok) {
+                return false;
+            }
+            if (match) {
+                *match->out = std::string_view(value_begin, static_cast<size_t>(p_ - value_begin));
+            }
+
+            skip_whitespace();
+            if (p_ == end_) {
+                return false;
+            }
+            if (*p_ == '}') {
+                ++p_;
+                return true;
+            }
+            if (*p_ != ',') {
+                return false;
+            }
+            ++p_;
+        }
+    }
+
+    bool array(int depth) {
+        if (depth > kMaxDepth) {
+            return false;
+        }
+        ++p_;  // '['
+        skip_whitespace();
+        if (p_ != end_ && *p_ == ']') {
+            ++p_;
+            return true;
+        }
+
+        while (true) {
+            if (!value(depth)) {
+                return false;
+            }
+            skip_whitespace();
+            if (p_ == end_) {
+                return false;
+            }
+            if (*p_ == ']') {
+                ++p_;
+                return true;
+            }
+            if (*p_ != ',') {
+                return false;
+            }
+            ++p_;
+        }
+    }
+
+    bool literal(const char* word) {
+        size_t length = std::strlen(word);
+        if (static_cast<size_t>(end_ - p_) < length || std::memcmp(p_, word, length) != 0) {
+            return false;
+        }
+        p_ += length;
+        return true;
+    }
+
+    static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    bool digits() {
+        const char* begin = p_;
+        while (p_ != end_ && is_digit(*p_)) {
+            ++p_;
+        }
+        return p_ != begin;
+    }
+
+    bool number() {
+        const char* begin = p_;
+        if (p_ != end_ && *p_ == '-') {
+            ++p_;
+        }
+        if (p_ == end_) {
+            return false;
+        }
+        if (*p_ == '0') {
+            ++p_;
+        } else if (!digits()) {
+            return false;
+        }
+        if (p_ != end_ && *p_ == '.') {
+            ++p_;
+            if (!digits()) {
+                return false;
+            }
+        }
+        if (p_ != end_ && (*p_ == 'e' || *p_ == 'E')) {
+            ++p_;
+            if (p_ != end_ && (*p_ == '+' || *p_ == '-')) {
+                ++p_;
+            }
+            if (!digits()) {
+                return false;
+            }
+            return representable(begin);
+        }
+        return p_ - begin < 300 || representable(begin);
+    }
+
+    // The full parser rejects numbers that overflow a double
+    bool representable(const char* begin) {
+        char buffer[64];
+        size_t length = static_cast<size_t>(p_ - begin);
+        if (length >= sizeof(buffer)) {
+            return false;
+        }
+        std::memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+        return std::isfinite(std::strtod(buffer, nullptr));
+    }
+
+    // Skips plain string bytes: everything except '"', '\\', control
+    // characters and non-ASCII bytes, which need a closer look
+    void skip_plain() {
+#ifdef CPPMCP_SCANNER_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control_max = _mm_set1_epi8(0x1F);
+        while (end_ - p_ >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_));
+            __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+            // Unsigned chunk <= 0x1F
+            special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max));
+            // High bit set: non-ASCII
+            int mask = _mm_movemask_epi8(special) | _mm_movemask_epi8(chunk);
+            if (mask != 0) {
+                p_ += __builtin_ctz(static_cast<unsigned>(mask));
+                return;
+            }
+            p_ += 16;
+        }
+#endif
+        while (p_ != end_) {
+            unsigned char c = static_cast<unsigned char>(*p_);
+            if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) {
+                return;
+            }
+            ++p_;
+        }
+    }
+
+    bool hex4(unsigned& code) {
+        if (end_ - p_ < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *p_++;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= static_cast<unsigned>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    bool escape() {
+        ++p_;  // '\\'
+        if (p_ == end_) {
+            return false;
+        }
+        char c = *p_++;
+        if (c != '\0' && std::strchr("\"\\/bfnrt", c)) {
+            return true;
+        }
+        if (c != 'u') {
+            return false;
+        }
+
+        // Surrogates must come in high/low pairs
+        unsigned code;
+        if (!hex4(code)) {
+            return false;
+        }
+        if (code >= 0xDC00 && code <= 0xDFFF) {
+            return false;
+        }
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            unsigned low;
+            if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+                return false;
+            }
+            p_ += 2;
+            if (!hex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Well-formed UTF-8 sequence, as accepted by the full parser
+    bool utf8() {
+        auto byte = [this](size_t i) { return static_cast<unsigned char>(p_[i]); };
+        auto in = [](unsigned char c, unsigned char lo, unsigned char hi) { return c >= lo && c <= hi; };
+        size_t available = static_cast<size_t>(end_ - p_);
+        unsigned char lead = byte(0);
+
+        size_t length;
+        unsigned char lo = 0x80, hi = 0xBF;  // range of the second byte
+        if (in(lead, 0xC2, 0xDF)) { length = 2; }
+        else if (lead == 0xE0) { length = 3; lo = 0xA0; }
+        else if (in(lead, 0xE1, 0xEC) || in(lead, 0xEE, 0xEF)) { length = 3; }
+        else if (lead == 0xED) { length = 3; hi = 0x9F; }
+        else if (lead == 0xF0) { length = 4; lo = 0x90; }
+        else if (in(lead, 0xF1, 0xF3)) { length = 4; }
+        else if (lead == 0xF4) { length = 4; hi = 0x8F; }
+        else { return false; }
+
+        if (available < length || !in(byte(1), lo, hi)) {
+            return false;
+        }
+        for (size_t i = 2; i < length; ++i) {
+            if (!in(byte(i), 0x80, 0xBF)) {
+                return false;
+            }
+        }
+        p_ += length;
+        return true;
+    }
+
+    bool string() {
+        ++p_;  // opening quote
+        while (true) {
+            skip_plain();
+            if (p_ == end_) {
+                return false;
+            }
+            unsigned char c = static_cast<unsigned char>(*p_);
+            if (c == '"') {
+                ++p_;
+                return true;
+            }
+            if (c == '\\') {
+                if (!escape()) {
+                    return false;
+                }
+            } else if (c >= 0x80) {
+                if (!utf8()) {
+                    return false;
+                }
+            } else {
+                return false;  // unescaped control character
+            }
+        }
+    }
+};
+
+} // namespace
+
+bool scan_message(std::string_view text, MessageEnvelope& envelope) {
+    envelope = MessageEnvelope();
+
+    // The tables point into this call's envelope, so they can't be static
+    const Wanted params_wanted[] = {
+        {"arguments", &envelope.arguments, nullptr, 0},
+    };
+    const Wanted message_wanted[] = {
+        {"jsonrpc", &envelope.jsonrpc, nullptr, 0},
+        {"id", &envelope.id, nullptr, 0},
+        {"method", &envelope.method, nullptr, 0},
+        {"params", &envelope.params, params_wanted, 1},
+    };
+
+    if (!Scanner(text).document(message_wanted, 4)) {
+        envelope = MessageEnvelope();
+        return false;
+    }
+    return true;
+}
+
+} // namespace mcp
@@ -0,0 +1,158 @@
+#include <cppmcp/json_writer.hpp>
+#include <memory>
+
+namespace mcp {
+
+namespace {
+
+using OutputAdapter = nlohmann::detail::output_adapter_protocol<char>;
+using StringAdapter = nlohmann::detail::output_string_adapter<char, std::string>;
+
+// Escapes serializer output so it reads as the contents of a JSON string.
+// Compact output never contains raw control characters, so only quotes
+// and backslashes need escaping.
+class EscapingAdapter : public OutputAdapter {
+public:
+    explicit EscapingAdapter(std::string& out) : out_(out) {}
+
+    void write_character(char c) override {
+        if (c == '"' || c == '\\') {
+            out_ += '\\';
+        }
+        out_ += c;
+    }
+
+    void write_characters(const char* s, std::size_t length) override {
+        const char* end = s + length;
+        while (s != end) {
+            const char* special = s;
+            while (special != end && *special != '"' && *special != '\\') {
+                ++special;
+            }
+            out_.append(s, static_cast<size_t>(special - s));
+            if (special == end) {
+                break;
+            }
+            out_ += '\\';
+            out_ += *special;
+            s = special + 1;
+        }
+    }
+
+private:
+    std::string& out_;
+};
+
+void serialize(std::shared_ptr<OutputAdapter> adapter, const json& value) {
+    nlohmann::detail::serializer<json> serializer(std::move(adapter), ' ');
+    serializer.dump(value, false, false, 0);
+}
+
+// Length of the well-formed UTF-8 sequence at p, or 0
+size_t utf8_sequence_length(const unsigned char* p, const unsigned char* end) {
+    auto in = [](unsigned char c, unsigned char lo, unsigned char hi) { return c >= lo && c <= hi; };
+    unsigned char lead = p[0];
+    size_t length;
+    unsigned char lo = 0x80, hi = 0xBF;  // range of the second byte
+    if (in(lead, 0xC2, 0xDF)) { length = 2; }
+    else if (lead == 0xE0) { length = 3; lo = 0xA0; }
+    else if (in(lead, 0xE1, 0xEC) || in(lead, 0xEE, 0xEF)) { length = 3; }
+    else if (lead == 0xED) { length = 3; hi = 0x9F; }
+    else if (lead == 0xF0) { length = 4; lo = 0x90; }
+    else if (in(lead, 0xF1, 0xF3)) { length = 4; }
+    else if (lead == 0xF4) { length = 4; hi = 0x8F; }
+    else { return 0; }
+
+    if (static_cast<size_t>(end - p) < length || !in(p[1], lo, hi)) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if (!in(p[i], 0x80, 0xBF)) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+} // namespace
+
+void write_json_string(std::string& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = p + text.size();
+
+    out += '"';
+    while (p != end) {
+        // Copy runs that need no escaping in one go
+        const unsigned char* run = p;
+        while (p != end && *p >= 0x20 && *p < 0x80 && *p != '"' && *p != '\\') {
+            ++p;
+        }
+        out.append(reinterpret_cast<const char*>(run), static_cast<size_t>(p - run));
+        if (p == end) {
+            break;
+        }
+
+        unsigned char c = *p;
+        if (c >= 0x80) {
+            size_t length = utf8_sequence_length(p, end);
+            if (length == 0) {
+                out += "\xEF\xBF\xBD";
+                ++p;
+            } else {
+                out.append(reinterpret_cast<const char*>(p), length);
+                p += length;
+            }
+            continue;
+        }
+
+        out += '\\';
+        switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '\b': out += 'b'; break;
+            case '\f': out += 'f'; break;
+            case '\n': out += 'n'; break;
+            case '\r': out += 'r'; break;
+            case '\t': out += 't'; break;
+            default:
+                out += "u00";
+                out += kHex[c >> 4];
+                out += kHex[c & 0xF];
+                break;
+        }
+        ++p;
+    }
+    out += '"';
+}
+
+void write_json(std::string& out, const json& value) {
+    serialize(std::make_shared<StringAdapter>(out), value);
+}
+
+void write_json_text(std::string& out, const json& value) {
+    out += '"';
+    serialize(std::make_shared<EscapingAdapter>(out), value);
+    out += '"';
+}
+
+void write_success_response(std::string& out, const json& id, std::string_view result) {
+    out.reserve(out.size() + result.size() + 48);
+    out += "{\"id\":";
+    write_json(out, id);
+    out += ",\"jsonrpc\":\"2.0\",\"result\":";
+    out += result;
+    out += '}';
+}
+
+void write_error_response(std::string& out, const json& id, int code, const std::string& message) {
+    out += "{\"error\":{\"code\":";
+    out += std::to_string(code);
+    out += ",\"message\":";
+    write_json(out, json(message));
+    out += "},\"id\":";
+    write_json(out, id);
+    out += ",\"jsonrpc\":\"2.0\"}";
+}
+
+} // namespace mcp
@@ -2,6 +2,23 @@
 #include <iostream>
 #include <cmath>
 
+// Tool arguments, decoded straight from the request
+struct BinaryArgs {
+    double a;
+    double b;
+};
+CPPMCP_TOOL_ARGS(BinaryArgs, a, b)
+
+struct SqrtArgs {
+    double value;
+};
+CPPMCP_TOOL_ARGS(SqrtArgs, value)
+
+struct GreetArgs {
+    std::string name;
+};
+CPPMCP_TOOL_ARGS(GreetArgs, name)
+
 int main(int argc, char* argv[]) {
     // Check transport mode
     std::string mode = "stdio";
@@ -18,74 +35,38 @@ int main(int argc, char* argv[]) {
     mcp::MCPServer server("cpp-example-server", "1.0.0");
     
     // Add tools
-    server.add_tool(
+    server.add_tool<BinaryArgs>(
         "add",
         "Add two numbers together",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"a", {{"type", "number"}, {"description", "First number"}}},
-                {"b", {{"type", "number"}, {"description", "Second number"}}}
-            }},
-            {"required", {"a", "b"}}
-        },
-        [](const json& args) -> json {
-            double a = args["a"].get<double>();
-            double b = args["b"].get<double>();
-            return a + b;
-        }
+        {{"a", "First number"}, {"b", "Second number"}},
+        [](const BinaryArgs& args) { return args.a + args.b; }
     );
     
-    server.add_tool(
+    server.add_tool<BinaryArgs>(
         "multiply",
         "Multiply two numbers",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"a", {{"type", "number"}, {"description", "First number"}}},
-                {"b", {{"type", "number"}, {"description", "Second number"}}}
-            }},
-            {"required", {"a", "b"}}
-        },
-        [](const json& args) -> json {
-            double a = args["a"].get<double>();
-            double b = args["b"].get<double>();
-            return a * b;
-        }
+        {{"a", "First number"}, {"b", "Second number"}},
+        [](const BinaryArgs& args) { return args.a * args.b; }
     );
     
-    server.add_tool(
+    server.add_tool<SqrtArgs>(
         "sqrt",
         "Calculate square root",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"value", {{"type", "number"}, {"description", "Number to calculate square root"}}}
-            }},
-            {"required", {"value"}}
-        },
-        [](const json& args) -> json {
-            double value = args["value"].get<double>();
-            if (value < 0) {
+        {{"value", "Number to calculate square root"}},
+        [](const SqrtArgs& args) {
+            if (args.value < 0) {
                 throw std::runtime_error("Cannot calculate square root of negative number");
             }
-            return std::sqrt(value);
+            return std::sqrt(args.value);
         }
     );
     
-    server.add_tool(
+    server.add_tool<GreetArgs>(
         "greet",
         "Generate a greeting message",
-        {
-            {"type", "object"},
-            {"properties", {
-                {"name", {{"type", "string"}, {"description", "Name to greet"}}}
-            }},
-            {"required", {"name"}}
-        },
-        [](const json& args) -> json {
-            std::string name = args["name"].get<std::string>();
-            return "Hello, " + name + "! Welcome to C++ MCP Server!";
+        {{"name", "Name to greet"}},
+        [](const GreetArgs& args) {
+            return "Hello, " + args.name + "! Welcome to C++ MCP Server!";
         }
     );
     
@@ -164,6 +145,13 @@ int main(int argc, char* argv[]) {
     // Run server based on mode
     if (mode == "sse" || mode == "http") {
         server.run_sse(port);
+    } else if (mode == "both") {
+        // HTTP in the background, STDIO until stdin closes
+        if (!server.start_sse(port)) {
+            return 1;
+        }
+        server.run_stdio();
+        server.stop_sse();
     } else {
         server.run_stdio();
     }
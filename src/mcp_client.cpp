@@ -1,4 +1,6 @@
 #include <cppmcp/mcp_client.hpp>
+#include <cppmcp/message_encoding.hpp>
+#include <cppmcp/message_limits.hpp>
 #include <iostream>
 #include <sstream>
 #include <unistd.h>
@@ -6,6 +8,9 @@
 #include <signal.h>
 #include <curl/curl.h>
 #include <cstring>
+#include <strings.h>
+#include <cerrno>
+#include <sys/uio.h>
 
 namespace mcp {
 
@@ -15,15 +20,33 @@ static size_t write_callback(void* contents, size_t size, size_t nmemb, void* us
     return size * nmemb;
 }
 
+// Picks the Mcp-Session-Id header out of a response
+static size_t session_header_callback(char* buffer, size_t size, size_t nitems, void* userp) {
+    size_t length = size * nitems;
+    std::string header(buffer, length);
+    static const std::string name = "mcp-session-id:";
+    if (header.size() > name.size() && strncasecmp(header.c_str(), name.c_str(), name.size()) == 0) {
+        size_t begin = header.find_first_not_of(" \t", name.size());
+        size_t end = header.find_last_not_of(" \t\r\n");
+        if (begin != std::string::npos && end >= begin) {
+            *static_cast<std::string*>(userp) = header.substr(begin, end - begin + 1);
+        }
+    }
+    return length;
+}
+
 MCPClient::MCPClient(const std::string& name, const std::string& version)
     : client_name_(name)
     , client_version_(version)
     , connected_(false)
     , request_id_(0)
+    , timeout_seconds_(10)
+    , encoding_(MessageEncoding::JSON)
     , process_pid_(-1)
     , stdin_fd_(-1)
     , stdout_fd_(-1)
-    , transport_type_(TransportType::STDIO) {
+    , transport_type_(TransportType::STDIO)
+    , stdio_framing_(StdioFraming::Newline) {
 }
 
 MCPClient::~MCPClient() {
@@ -78,6 +101,7 @@ bool MCPClient::connect_stdio(const std::string& command, const std::vector<std:
     
     stdin_fd_ = stdin_pipe[1];
     stdout_fd_ = stdout_pipe[0];
+    reader_ = std::make_unique<FrameReader>(stdout_fd_);
     
     transport_type_ = TransportType::STDIO;
     connected_ = true;
@@ -126,12 +150,15 @@ void MCPClient::disconnect() {
     if (transport_type_ == TransportType::STDIO) {
         if (stdin_fd_ >= 0) close(stdin_fd_);
         if (stdout_fd_ >= 0) close(stdout_fd_);
+        stdin_fd_ = stdout_fd_ = -1;
+        reader_.reset();
         
         if (process_pid_ > 0) {
             kill(process_pid_, SIGTERM);
             waitpid(process_pid_, nullptr, 0);
         }
     }
+    session_id_.clear();
     
     connected_ = false;
     std::cerr << "Disconnected from MCP server" << std::endl;
@@ -183,18 +210,28 @@ bool MCPClient::initialize() {
 }
 
 std::vector<Tool> MCPClient::list_tools() {
-    json response = send_request("tools/list");
     std::vector<Tool> tools;
+    json params = json::object();
     
-    if (response.contains("result") && response["result"].contains("tools")) {
-        for (const auto& tool_json : response["result"]["tools"]) {
-            Tool tool;
-            tool.name = tool_json["name"].get<std::string>();
-            tool.description = tool_json.value("description", "");
-            tool.input_schema = tool_json.value("inputSchema", json::object());
-            tools.push_back(tool);
+    // Follow nextCursor until the server reports the last page
+    do {
+        json response = send_request("tools/list", params);
+        params = json::object();
+        
+        if (response.contains("result") && response["result"].contains("tools")) {
+            for (const auto& tool_json : response["result"]["tools"]) {
+                Tool tool;
+                tool.name = tool_json["name"].get<std::string>();
+                tool.description = tool_json.value("description", "");
+                tool.input_schema = tool_json.value("inputSchema", json::object());
+                tools.push_back(tool);
+            }
+            
+            if (response["result"].contains("nextCursor")) {
+                params["cursor"] = response["result"]["nextCursor"];
+            }
         }
-    }
+    } while (!params.empty());
     
     return tools;
 }
@@ -205,6 +242,11 @@ json MCPClient::call_tool(const std::string& name, const json& arguments) {
         {"arguments", arguments}
     };
     
+    // Ask for progress notifications, using the request id as the token
+    if (notification_handler_) {
+        params["_meta"] = {{"progressToken", request_id_ + 1}};
+    }
+    
     json response = send_request("tools/call", params);
     
     if (response.contains("result")) {
@@ -215,19 +257,28 @@ json MCPClient::call_tool(const std::string& name, const json& arguments) {
 }
 
 std::vector<Resource> MCPClient::list_resources() {
-    json response = send_request("resources/list");
     std::vector<Resource> resources;
+    json params = json::object();
     
-    if (response.contains("result") && response["result"].contains("resources")) {
-        for (const auto& res_json : response["result"]["resources"]) {
-            Resource resource;
-            resource.uri = res_json["uri"].get<std::string>();
-            resource.name = res_json.value("name", "");
-            resource.description = res_json.value("description", "");
-            resource.mime_type = res_json.value("mimeType", "");
-            resources.push_back(resource);
+    do {
+        json response = send_request("resources/list", params);
+        params = json::object();
+        
+        if (response.contains("result") && response["result"].contains("resources")) {
+            for (const auto& res_json : response["result"]["resources"]) {
+                Resource resource;
+                resource.uri = res_json["uri"].get<std::string>();
+                resource.name = res_json.value("name", "");
+                resource.description = res_json.value("description", "");
+                resource.mime_type = res_json.value("mimeType", "");
+                resources.push_back(resource);
+            }
+            
+            if (response["result"].contains("nextCursor")) {
+                params["cursor"] = response["result"]["nextCursor"];
+            }
         }
-    }
+    } while (!params.empty());
     
     return resources;
 }
@@ -291,7 +342,17 @@ json MCPClient::send_request(const std::string& method, const json& params) {
     
     if (transport_type_ == TransportType::STDIO) {
         write_request(request);
-        return read_response();
+        
+        // Notifications may arrive before the response; hand them off
+        while (true) {
+            json message = read_response();
+            if (message.empty() || (message.contains("id") && message["id"] == request["id"])) {
+                return message;
+            }
+            if (!message.contains("id") && notification_handler_) {
+                notification_handler_(message);
+            }
+        }
     } else if (transport_type_ == TransportType::SSE) {
         // For SSE, do POST request and get response synchronously
         CURL* curl = curl_easy_init();
@@ -300,17 +361,27 @@ json MCPClient::send_request(const std::string& method, const json& params) {
         }
         
         std::string url = sse_url_ + sse_endpoint_;
-        std::string request_str = request.dump();
+        std::string request_str = encode_message(request, encoding_);
         std::string response_data;
         
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_str.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_str.data());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request_str.size()));
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds_);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, session_header_callback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &session_id_);
         
+        // Binary encodings are asked for both ways; a server may still
+        // answer in JSON, so the response is decoded by its Content-Type
+        std::string media_type = content_type(encoding_);
         struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
+        headers = curl_slist_append(headers, ("Content-Type: " + media_type).c_str());
+        headers = curl_slist_append(headers, ("Accept: " + media_type).c_str());
+        if (!session_id_.empty()) {
+            headers = curl_slist_append(headers, ("Mcp-Session-Id: " + session_id_).c_str());
+        }
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         
         CURLcode res = curl_easy_perform(curl);
@@ -318,6 +389,9 @@ json MCPClient::send_request(const std::string& method, const json& params) {
         
         long http_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        char* response_type = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &response_type);
+        MessageEncoding response_encoding = encoding_from_content_type(response_type ? response_type : "");
         curl_easy_cleanup(curl);
         
         if (res != CURLE_OK) {
@@ -330,7 +404,7 @@ json MCPClient::send_request(const std::string& method, const json& params) {
         }
         
         if (!response_data.empty()) {
-            return json::parse(response_data);
+            return decode_message(response_data, response_encoding);
         }
         
         return json::object();
@@ -343,10 +417,33 @@ void MCPClient::write_request(const json& request) {
     std::string request_str = request.dump();
     
     if (transport_type_ == TransportType::STDIO) {
-        request_str += "\n";
-        ssize_t written = write(stdin_fd_, request_str.c_str(), request_str.length());
-        if (written < 0) {
-            throw std::runtime_error("Failed to write to stdin");
+        std::string header;
+        if (stdio_framing_ == StdioFraming::ContentLength) {
+            header = content_length_header(request_str.size());
+        } else {
+            request_str += "\n";
+        }
+        
+        // Header and body in one writev, resumed after partial writes
+        iovec iov[2] = {{&header[0], header.size()}, {&request_str[0], request_str.size()}};
+        iovec* next = header.empty() ? iov + 1 : iov;
+        while (next != iov + 2) {
+            ssize_t written = writev(stdin_fd_, next, static_cast<int>(iov + 2 - next));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to write to stdin");
+            }
+            size_t remaining = static_cast<size_t>(written);
+            while (next != iov + 2 && remaining >= next->iov_len) {
+                remaining -= next->iov_len;
+                ++next;
+            }
+            if (remaining > 0) {
+                next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+                next->iov_len -= remaining;
+            }
         }
         
     } else if (transport_type_ == TransportType::SSE) {
@@ -357,15 +454,11 @@ void MCPClient::write_request(const json& request) {
 
 json MCPClient::read_response() {
     if (transport_type_ == TransportType::STDIO) {
-        std::string line;
-        char c;
-        while (read(stdout_fd_, &c, 1) > 0) {
-            if (c == '\n') break;
-            line += c;
-        }
-        
-        if (!line.empty()) {
-            return json::parse(line);
+        // Buffered; Content-Length bodies are read at their exact size
+        std::string message;
+        MessageLimiter limiter(0, 0);
+        if (reader_ && reader_->read(message, limiter) && !message.empty()) {
+            return json::parse(message);
         }
         
     } else if (transport_type_ == TransportType::SSE) {
@@ -1,16 +1,203 @@
 #include <cppmcp/mcp_server.hpp>
+#include <cppmcp/worker_pool.hpp>
+#include <cppmcp/event_loop.hpp>
+#include <cppmcp/base64.hpp>
+#include <cppmcp/json_arena.hpp>
+#include <cppmcp/json_scanner.hpp>
+#include <cppmcp/json_writer.hpp>
+#include <cppmcp/message_limits.hpp>
+#include <cppmcp/schema_validator.hpp>
+#include <cppmcp/stdio_transport.hpp>
 #include <iostream>
 #include <sstream>
 #include <thread>
 #include <cstring>
+#include <future>
+#include <condition_variable>
+#include <algorithm>
+#include <cmath>
+#include <unistd.h>
 
 namespace mcp {
 
+// Longest deadline a client can ask for with _meta.timeoutMs; longer ones
+// are clamped so the deadline stays within the clock's range
+static const std::chrono::hours kMaxRequestTimeout(24);
+
+struct ToolCompletion::State {
+    std::function<void(std::string result, std::exception_ptr error)> done;
+    std::shared_ptr<RequestContext> context;
+    std::atomic<bool> completed{false};
+
+    void complete(std::string result, std::exception_ptr error) {
+        if (!completed.exchange(true)) {
+            done(std::move(result), error);
+        }
+    }
+
+    ~State() {
+        complete(std::string(), std::make_exception_ptr(
+            std::runtime_error("Tool execution failed: tool did not complete")));
+    }
+};
+
+// MCP wraps tool results in a single text content block. The result is
+// serialized straight into the block's escaped text, never as a separate
+// string that would be escaped a second time.
+static std::string serialize_tool_result(const json& result) {
+    std::string out = "{\"content\":[{\"text\":";
+    if (result.is_string()) {
+        write_json(out, result);
+    } else {
+        write_json_text(out, result);
+    }
+    out += ",\"type\":\"text\"}]}";
+    return out;
+}
+
+void ToolCompletion::resolve(const json& result) const {
+    state_->complete(serialize_tool_result(result), nullptr);
+}
+
+void ToolCompletion::resolve(ToolResult result) const {
+    state_->complete(result.release(), nullptr);
+}
+
+void ToolCompletion::reject(const std::string& message) const {
+    state_->complete(std::string(), std::make_exception_ptr(
+        std::runtime_error("Tool execution failed: " + message)));
+}
+
+RequestContext& ToolCompletion::context() const {
+    return *state_->context;
+}
+
 MCPServer::MCPServer(const std::string& name, const std::string& version)
-    : server_name_(name), server_version_(version), initialized_(false) {
+    : server_name_(name), server_version_(version),
+      pending_tools_(false), pending_resources_(false), pending_prompts_(false),
+      batch_depth_(0), default_session_(std::make_shared<Session>()), next_sink_id_(0), page_size_(0),
+      max_message_bytes_(128 * 1024 * 1024), max_message_depth_(256),
+      max_queued_output_(16 * 1024 * 1024), stdio_framing_(StdioFraming::Auto),
+      lazy_parsing_(false), default_tool_timeout_(std::chrono::milliseconds(0)) {
+    auto registry = std::make_shared<Registry>();
+    registry->tools = std::make_shared<Catalog<Tool>>();
+    registry->resources = std::make_shared<Catalog<Resource>>();
+    registry->prompts = std::make_shared<Catalog<Prompt>>();
+    registry_ = std::move(registry);
+    
+    register_builtin_methods();
 }
 
 MCPServer::~MCPServer() {
+    stop_sse();
+    
+    // Workers may still arm timers; the loop goes once they are done
+    worker_pool_.reset();
+    event_loop_.reset();
+}
+
+EventLoop& MCPServer::event_loop() {
+    std::call_once(event_loop_once_, [this] { event_loop_ = std::make_unique<EventLoop>(); });
+    return *event_loop_;
+}
+
+std::shared_ptr<const MCPServer::Registry> MCPServer::registry_snapshot() const {
+    return std::atomic_load(&registry_);
+}
+
+// The pending_* helpers must be called with registry_write_mutex_ held.
+// The first change to a catalog in a pending version copies it; further
+// changes in the same batch reuse that copy.
+MCPServer::Registry& MCPServer::pending_registry() {
+    if (!pending_registry_) {
+        pending_registry_ = std::make_shared<Registry>(*registry_snapshot());
+    }
+    return *pending_registry_;
+}
+
+MCPServer::Catalog<Tool>& MCPServer::pending_tools() {
+    Registry& registry = pending_registry();
+    if (!pending_tools_) {
+        registry.tools = std::make_shared<Catalog<Tool>>(*registry.tools);
+        pending_tools_ = true;
+    }
+    return *registry.tools;
+}
+
+MCPServer::Catalog<Resource>& MCPServer::pending_resources() {
+    Registry& registry = pending_registry();
+    if (!pending_resources_) {
+        registry.resources = std::make_shared<Catalog<Resource>>(*registry.resources);
+        pending_resources_ = true;
+    }
+    return *registry.resources;
+}
+
+MCPServer::Catalog<Prompt>& MCPServer::pending_prompts() {
+    Registry& registry = pending_registry();
+    if (!pending_prompts_) {
+        registry.prompts = std::make_shared<Catalog<Prompt>>(*registry.prompts);
+        pending_prompts_ = true;
+    }
+    return *registry.prompts;
+}
+
+std::vector<std::string> MCPServer::publish_registry() {
+    std::vector<std::string> changed;
+    if (batch_depth_ > 0 || !pending_registry_) {
+        return changed;
+    }
+    
+    std::atomic_store(&registry_, std::shared_ptr<const Registry>(std::move(pending_registry_)));
+    pending_registry_.reset();
+    
+    if (pending_tools_) changed.push_back("notifications/tools/list_changed");
+    if (pending_resources_) changed.push_back("notifications/resources/list_changed");
+    if (pending_prompts_) changed.push_back("notifications/prompts/list_changed");
+    pending_tools_ = pending_resources_ = pending_prompts_ = false;
+    
+    return changed;
+}
+
+void MCPServer::notify_list_changed(const std::vector<std::string>& methods) {
+    if (methods.empty()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(broadcast_mutex_);
+    for (const auto& method : methods) {
+        std::string notification = json{{"jsonrpc", "2.0"}, {"method", method}}.dump();
+        for (auto& [id, sink] : broadcast_sinks_) {
+            if (!sink.session || sink.session->initialized) {
+                sink.sink(notification);
+            }
+        }
+    }
+}
+
+int MCPServer::add_broadcast_sink(NotificationSink sink, std::shared_ptr<Session> session) {
+    std::lock_guard<std::mutex> lock(broadcast_mutex_);
+    int id = next_sink_id_++;
+    broadcast_sinks_[id] = BroadcastSink{std::move(sink), std::move(session)};
+    return id;
+}
+
+void MCPServer::remove_broadcast_sink(int id) {
+    std::lock_guard<std::mutex> lock(broadcast_mutex_);
+    broadcast_sinks_.erase(id);
+}
+
+MCPServer::RegistrationBatch::RegistrationBatch(MCPServer& server)
+    : server_(server) {
+    server_.registry_write_mutex_.lock();
+    ++server_.batch_depth_;
+}
+
+MCPServer::RegistrationBatch::~RegistrationBatch() {
+    --server_.batch_depth_;
+    std::vector<std::string> changed = server_.publish_registry();
+    server_.registry_write_mutex_.unlock();
+    server_.notify_list_changed(changed);
 }
 
 void MCPServer::add_tool(const std::string& name, const std::string& description,
@@ -19,8 +206,52 @@ void MCPServer::add_tool(const std::string& name, const std::string& description
     tool.name = name;
     tool.description = description;
     tool.input_schema = input_schema;
-    tool.function = func;
-    tools_[name] = tool;
+    tool.function = std::move(func);
+    add_tool_entry(std::move(tool));
+}
+
+void MCPServer::add_tool(const std::string& name, const std::string& description,
+                        const json& input_schema, ContentToolFunction func) {
+    Tool tool;
+    tool.name = name;
+    tool.description = description;
+    tool.input_schema = input_schema;
+    tool.content_function = std::move(func);
+    add_tool_entry(std::move(tool));
+}
+
+void MCPServer::add_async_tool(const std::string& name, const std::string& description,
+                              const json& input_schema, AsyncToolFunction func) {
+    Tool tool;
+    tool.name = name;
+    tool.description = description;
+    tool.input_schema = input_schema;
+    tool.async_function = std::move(func);
+    add_tool_entry(std::move(tool));
+}
+
+void MCPServer::add_tool_entry(Tool tool) {
+    auto validator = std::make_shared<const SchemaValidator>(tool.input_schema);
+    if (validator->has_constraints()) {
+        tool.validator = std::move(validator);
+    }
+    
+    auto entry = std::make_shared<CatalogEntry<Tool>>();
+    entry->serialized = json{
+        {"name", tool.name},
+        {"description", tool.description},
+        {"inputSchema", tool.input_schema}
+    }.dump();
+    std::string name = tool.name;
+    entry->item = std::move(tool);
+    
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        pending_tools().entries[name] = std::move(entry);
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
 }
 
 void MCPServer::add_resource(const std::string& uri, const std::string& name,
@@ -31,21 +262,211 @@ void MCPServer::add_resource(const std::string& uri, const std::string& name,
     resource.name = name;
     resource.description = description;
     resource.mime_type = mime_type;
-    resource.function = func;
-    resources_[uri] = resource;
+    resource.function = std::move(func);
+    add_resource_entry(std::move(resource));
+}
+
+void MCPServer::add_blob_resource(const std::string& uri, const std::string& name,
+                                 const std::string& description, const std::string& mime_type,
+                                 ResourceFunction func) {
+    Resource resource;
+    resource.uri = uri;
+    resource.name = name;
+    resource.description = description;
+    resource.mime_type = mime_type;
+    resource.function = std::move(func);
+    resource.binary = true;
+    add_resource_entry(std::move(resource));
+}
+
+void MCPServer::add_resource_entry(Resource resource) {
+    auto entry = std::make_shared<CatalogEntry<Resource>>();
+    entry->serialized = json{
+        {"uri", resource.uri},
+        {"name", resource.name},
+        {"description", resource.description},
+        {"mimeType", resource.mime_type}
+    }.dump();
+    std::string uri = resource.uri;
+    entry->item = std::move(resource);
+    
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        pending_resources().entries[uri] = std::move(entry);
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
 }
 
 void MCPServer::add_prompt(const std::string& name, const std::string& description,
                           const json& arguments, PromptFunction func) {
-    Prompt prompt;
-    prompt.name = name;
-    prompt.description = description;
-    prompt.arguments = arguments;
-    prompt.function = func;
-    prompts_[name] = prompt;
+    auto entry = std::make_shared<CatalogEntry<Prompt>>();
+    entry->item.name = name;
+    entry->item.description = description;
+    entry->item.arguments = arguments;
+    entry->item.function = func;
+    entry->serialized = json{
+        {"name", name},
+        {"description", description},
+        {"arguments", arguments}
+    }.dump();
+    
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        pending_prompts().entries[name] = std::move(entry);
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
+}
+
+bool MCPServer::remove_tool(const std::string& name) {
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        if (!registry_snapshot()->tools->entries.count(name) &&
+            !(pending_registry_ && pending_registry_->tools->entries.count(name))) {
+            return false;
+        }
+        pending_tools().entries.erase(name);
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
+    return true;
+}
+
+bool MCPServer::remove_resource(const std::string& uri) {
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        if (!registry_snapshot()->resources->entries.count(uri) &&
+            !(pending_registry_ && pending_registry_->resources->entries.count(uri))) {
+            return false;
+        }
+        pending_resources().entries.erase(uri);
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
+    return true;
+}
+
+bool MCPServer::remove_prompt(const std::string& name) {
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        if (!registry_snapshot()->prompts->entries.count(name) &&
+            !(pending_registry_ && pending_registry_->prompts->entries.count(name))) {
+            return false;
+        }
+        pending_prompts().entries.erase(name);
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
+    return true;
+}
+
+void MCPServer::set_worker_threads(size_t threads, size_t max_queued) {
+    if (threads == 0) {
+        worker_pool_.reset();
+    } else {
+        worker_pool_ = std::make_unique<WorkerPool>(threads, max_queued);
+    }
+}
+
+void MCPServer::set_tool_timeout(const std::string& name, std::chrono::milliseconds timeout) {
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registry_write_mutex_);
+        bool listing_changed = pending_tools_;
+        auto& entries = pending_tools().entries;
+        auto it = entries.find(name);
+        if (it == entries.end()) {
+            throw std::runtime_error("Tool not found: " + name);
+        }
+        
+        // Entries are shared with published versions, so replace rather than modify
+        auto entry = std::make_shared<CatalogEntry<Tool>>(*it->second);
+        entry->item.timeout = timeout;
+        it->second = std::move(entry);
+        
+        // A timeout doesn't change the listing, so don't announce it
+        pending_tools_ = listing_changed;
+        changed = publish_registry();
+    }
+    notify_list_changed(changed);
+}
+
+void MCPServer::set_default_tool_timeout(std::chrono::milliseconds timeout) {
+    default_tool_timeout_ = timeout;
+}
+
+void MCPServer::set_page_size(size_t page_size) {
+    page_size_ = page_size;
+}
+
+void MCPServer::set_message_limits(size_t max_bytes, size_t max_depth) {
+    max_message_bytes_ = max_bytes;
+    max_message_depth_ = max_depth;
+}
+
+void MCPServer::set_output_queue_limit(size_t max_bytes) {
+    max_queued_output_ = max_bytes;
+}
+
+void MCPServer::set_stdio_framing(StdioFraming framing) {
+    stdio_framing_ = framing;
 }
 
-json MCPServer::create_error_response(int id, int code, const std::string& message) {
+void MCPServer::set_lazy_parsing(bool enabled) {
+    lazy_parsing_ = enabled;
+}
+
+void MCPServer::register_method(const std::string& method, MethodHandler handler,
+                                bool requires_initialization) {
+    methods_[method] = MethodEntry{std::move(handler), nullptr, nullptr, nullptr, requires_initialization};
+}
+
+void MCPServer::register_raw_method(const std::string& method, RawMethodHandler handler) {
+    methods_[method] = MethodEntry{nullptr, std::move(handler), nullptr, nullptr, true};
+}
+
+void MCPServer::register_async_method(const std::string& method, AsyncMethodHandler handler) {
+    methods_[method] = MethodEntry{nullptr, nullptr, std::move(handler), nullptr, true};
+}
+
+void MCPServer::register_session_method(const std::string& method, SessionMethodHandler handler) {
+    methods_[method] = MethodEntry{nullptr, nullptr, nullptr, std::move(handler), false};
+}
+
+void MCPServer::register_builtin_methods() {
+    methods_.reserve(16);
+    
+    register_session_method("initialize",
+        [this](Session& session, const json& params) { return handle_initialize(session, params); });
+    register_method("ping",
+        [](const json&) { return json::object(); }, false);
+    register_session_method("notifications/cancelled",
+        [this](Session& session, const json& params) { return handle_cancelled(session, params); });
+    
+    register_raw_method("tools/list",
+        [this](const json& params) { return handle_tools_list(params); });
+    register_async_method("tools/call",
+        [this](const json& params, std::string_view raw_arguments,
+               const std::shared_ptr<RequestContext>& context, MethodCompletion done) {
+            handle_tools_call(params, raw_arguments, context, std::move(done));
+        });
+    register_raw_method("resources/list",
+        [this](const json& params) { return handle_resources_list(params); });
+    register_raw_method("resources/read",
+        [this](const json& params) { return handle_resources_read(params); });
+    register_raw_method("prompts/list",
+        [this](const json& params) { return handle_prompts_list(params); });
+    register_method("prompts/get",
+        [this](const json& params) { return handle_prompts_get(params); });
+}
+
+json MCPServer::create_error_response(const json& id, int code, const std::string& message) {
     return {
         {"jsonrpc", "2.0"},
         {"id", id},
@@ -56,7 +477,7 @@ json MCPServer::create_error_response(int id, int code, const std::string& messa
     };
 }
 
-json MCPServer::create_success_response(int id, const json& result) {
+json MCPServer::create_success_response(const json& id, const json& result) {
     return {
         {"jsonrpc", "2.0"},
         {"id", id},
@@ -64,30 +485,68 @@ json MCPServer::create_success_response(int id, const json& result) {
     };
 }
 
-json MCPServer::handle_initialize(const json& params) {
-    initialized_ = true;
+std::string MCPServer::serialize_success_response(const json& id, const std::string& result) {
+    // Same layout as create_success_response(...).dump(), with the result
+    // spliced in verbatim
+    std::string response;
+    write_success_response(response, id, result);
+    return response;
+}
+
+std::string MCPServer::serialize_error_response(const json& id, int code, const std::string& message) {
+    std::string response;
+    write_error_response(response, id, code, message);
+    return response;
+}
+
+json MCPServer::handle_cancelled(Session& session, const json& params) {
+    if (!params.is_object() || !params.contains("requestId")) {
+        return json();
+    }
     
+    // Request ids are only unique within the session that sent them
+    std::lock_guard<std::mutex> lock(session.mutex);
+    auto it = session.in_flight.find(params["requestId"].dump());
+    if (it != session.in_flight.end()) {
+        std::cerr << "Cancelling request " << it->first;
+        if (params.contains("reason") && params["reason"].is_string()) {
+            std::cerr << ": " << params["reason"].get<std::string>();
+        }
+        std::cerr << std::endl;
+        it->second->cancel();
+    }
+    return json();
+}
+
+json MCPServer::handle_initialize(Session& session, const json& params) {
     if (params.contains("clientInfo")) {
-        client_info_ = params["clientInfo"];
+        std::lock_guard<std::mutex> lock(session.mutex);
+        session.client_info = params["clientInfo"];
     }
+    session.initialized = true;
+
+    auto registry = registry_snapshot();
 
-    // MCP protocol requires capabilities to be objects, not booleans
+    // MCP protocol requires capabilities to be objects, not booleans.
+    // The catalogs can change at runtime, so listChanged is advertised.
     json capabilities = json::object();
     
-    if (!tools_.empty()) {
-        capabilities["tools"] = json::object();
+    if (!registry->tools->entries.empty()) {
+        capabilities["tools"] = {
+            {"listChanged", true}
+        };
     }
     
-    if (!resources_.empty()) {
+    if (!registry->resources->entries.empty()) {
         capabilities["resources"] = {
             {"subscribe", false},  // We don't support subscriptions yet
-            {"listChanged", false}
+            {"listChanged", true}
         };
     }
     
-    if (!prompts_.empty()) {
+    if (!registry->prompts->entries.empty()) {
         capabilities["prompts"] = {
-            {"listChanged", false}
+            {"listChanged", true}
         };
     }
 
@@ -101,105 +560,185 @@ json MCPServer::handle_initialize(const json& params) {
     };
 }
 
-json MCPServer::handle_tools_list(const json& params) {
-    json tools_array = json::array();
+template <typename T>
+std::string MCPServer::list_catalog(const char* key, const Catalog<T>& catalog, const json& params) {
+    std::string prefix = std::string("\"") + key + "\":[";
+    const auto& entries = catalog.entries;
     
-    for (const auto& [name, tool] : tools_) {
-        tools_array.push_back({
-            {"name", tool.name},
-            {"description", tool.description},
-            {"inputSchema", tool.input_schema}
+    size_t page_size = page_size_;
+    if (page_size == 0) {
+        std::call_once(catalog.list_once, [&] {
+            std::string out = "{" + prefix;
+            bool first = true;
+            for (const auto& [entry_key, entry] : entries) {
+                if (!first) out += ',';
+                first = false;
+                out += entry->serialized;
+            }
+            out += "]}";
+            catalog.list = std::move(out);
         });
+        return catalog.list;
+    }
+    
+    // The cursor encodes the last key of the previous page. Resuming with
+    // upper_bound keeps paging stable while entries are being added.
+    auto it = entries.begin();
+    if (params.is_object() && params.contains("cursor")) {
+        std::string last_key;
+        if (!params["cursor"].is_string() ||
+            !base64_decode(params["cursor"].get_ref<const std::string&>(), last_key)) {
+            throw JsonRpcError(-32602, "Invalid cursor");
+        }
+        it = entries.upper_bound(last_key);
     }
     
-    return {{"tools", tools_array}};
+    std::string page = prefix;
+    size_t count = 0;
+    const std::string* last_key = nullptr;
+    for (; it != entries.end() && count < page_size; ++it, ++count) {
+        if (count > 0) page += ',';
+        page += it->second->serialized;
+        last_key = &it->first;
+    }
+    page += ']';
+    
+    if (it != entries.end() && last_key) {
+        return "{\"nextCursor\":" + json(base64_encode(*last_key)).dump() + "," + page + "}";
+    }
+    return "{" + page + "}";
+}
+
+std::string MCPServer::handle_tools_list(const json& params) {
+    auto registry = registry_snapshot();
+    return list_catalog("tools", *registry->tools, params);
 }
 
-json MCPServer::handle_tools_call(const json& params) {
+void MCPServer::handle_tools_call(const json& params, std::string_view raw_arguments,
+                                  const std::shared_ptr<RequestContext>& context, MethodCompletion done) {
     if (!params.contains("name")) {
         throw std::runtime_error("Missing 'name' parameter");
     }
     
     std::string tool_name = params["name"];
     
-    if (tools_.find(tool_name) == tools_.end()) {
-        throw std::runtime_error("Tool not found: " + tool_name);
+    // Holding the entry keeps the tool alive even if it is removed meanwhile
+    std::shared_ptr<const CatalogEntry<Tool>> entry;
+    {
+        auto registry = registry_snapshot();
+        auto it = registry->tools->entries.find(tool_name);
+        if (it == registry->tools->entries.end()) {
+            throw std::runtime_error("Tool not found: " + tool_name);
+        }
+        entry = it->second;
     }
+    const Tool& tool = entry->item;
     
-    json arguments = params.contains("arguments") ? params["arguments"] : json::object();
+    // Arguments are borrowed from the request; tools receive a reference.
+    // Lazily parsed messages materialize them only now that the call runs.
+    static const json no_arguments = json::object();
+    json parsed_arguments;
+    if (!raw_arguments.empty()) {
+        parsed_arguments = json::parse(raw_arguments.begin(), raw_arguments.end());
+    }
+    const json& arguments = !raw_arguments.empty() ? parsed_arguments
+                          : params.contains("arguments") ? params["arguments"] : no_arguments;
     
-    try {
-        json result = tools_[tool_name].function(arguments);
-        
-        // Format result according to MCP spec
-        return {
-            {"content", json::array({
-                {
-                    {"type", "text"},
-                    {"text", result.is_string() ? result.get<std::string>() : result.dump()}
-                }
-            })}
+    // Reject malformed calls before they reach the tool
+    std::string invalid;
+    if (tool.validator && !tool.validator->validate(arguments, invalid)) {
+        throw JsonRpcError(-32602, "Invalid arguments for tool " + tool_name + ": " + invalid);
+    }
+    
+    // Apply the tool's deadline on top of any the client asked for
+    std::chrono::milliseconds timeout = tool.timeout.count() > 0 ? tool.timeout
+                                                                 : default_tool_timeout_.load();
+    if (timeout.count() > 0 && context->cancellation_token()) {
+        context->cancellation_token()->set_deadline(CancellationToken::Clock::now() + timeout);
+    }
+    
+    // Asynchronous tools return right away and complete through the handle
+    if (tool.async_function) {
+        auto state = std::make_shared<ToolCompletion::State>();
+        state->done = [entry, done = std::move(done)](std::string result, std::exception_ptr error) {
+            done(std::move(result), error);
         };
+        state->context = context;
+        
+        ToolCompletion completion(state);
+        state.reset();
+        try {
+            tool.async_function(arguments, completion);
+        } catch (const std::exception& e) {
+            completion.reject(e.what());
+        }
+        return;
+    }
+    
+    std::string result;
+    try {
+        result = tool.content_function ? tool.content_function(arguments).release()
+                                       : serialize_tool_result(tool.function(arguments));
     } catch (const std::exception& e) {
         throw std::runtime_error("Tool execution failed: " + std::string(e.what()));
     }
+    done(std::move(result), nullptr);
 }
 
-json MCPServer::handle_resources_list(const json& params) {
-    json resources_array = json::array();
-    
-    for (const auto& [uri, resource] : resources_) {
-        resources_array.push_back({
-            {"uri", resource.uri},
-            {"name", resource.name},
-            {"description", resource.description},
-            {"mimeType", resource.mime_type}
-        });
-    }
-    
-    return {{"resources", resources_array}};
+std::string MCPServer::handle_resources_list(const json& params) {
+    auto registry = registry_snapshot();
+    return list_catalog("resources", *registry->resources, params);
 }
 
-json MCPServer::handle_resources_read(const json& params) {
+std::string MCPServer::handle_resources_read(const json& params) {
     if (!params.contains("uri")) {
         throw std::runtime_error("Missing 'uri' parameter");
     }
     
     std::string uri = params["uri"];
     
-    if (resources_.find(uri) == resources_.end()) {
-        throw std::runtime_error("Resource not found: " + uri);
+    std::shared_ptr<const CatalogEntry<Resource>> entry;
+    {
+        auto registry = registry_snapshot();
+        auto it = registry->resources->entries.find(uri);
+        if (it == registry->resources->entries.end()) {
+            throw std::runtime_error("Resource not found: " + uri);
+        }
+        entry = it->second;
     }
     
+    std::string content;
     try {
-        std::string content = resources_[uri].function();
-        
-        return {
-            {"contents", json::array({
-                {
-                    {"uri", uri},
-                    {"mimeType", resources_[uri].mime_type},
-                    {"text", content}
-                }
-            })}
-        };
+        content = entry->item.function();
     } catch (const std::exception& e) {
         throw std::runtime_error("Resource read failed: " + std::string(e.what()));
     }
-}
-
-json MCPServer::handle_prompts_list(const json& params) {
-    json prompts_array = json::array();
     
-    for (const auto& [name, prompt] : prompts_) {
-        prompts_array.push_back({
-            {"name", prompt.name},
-            {"description", prompt.description},
-            {"arguments", prompt.arguments}
-        });
+    // Written with keys in sorted order, as json::dump() would; blobs are
+    // encoded in place rather than through an intermediate string
+    std::string result;
+    size_t content_size = entry->item.binary ? (content.size() + 2) / 3 * 4 : content.size();
+    result.reserve(content_size + uri.size() + entry->item.mime_type.size() + 64);
+    if (entry->item.binary) {
+        result += "{\"contents\":[{\"blob\":\"";
+        base64_encode_append(result, content.data(), content.size());
+        result += "\",\"mimeType\":";
+        write_json_string(result, entry->item.mime_type);
+    } else {
+        result += "{\"contents\":[{\"mimeType\":";
+        write_json_string(result, entry->item.mime_type);
+        result += ",\"text\":";
+        write_json_string(result, content);
     }
-    
-    return {{"prompts", prompts_array}};
+    result += ",\"uri\":";
+    write_json_string(result, uri);
+    result += "}]}";
+    return result;
+}
+
+std::string MCPServer::handle_prompts_list(const json& params) {
+    auto registry = registry_snapshot();
+    return list_catalog("prompts", *registry->prompts, params);
 }
 
 json MCPServer::handle_prompts_get(const json& params) {
@@ -209,18 +748,25 @@ json MCPServer::handle_prompts_get(const json& params) {
     
     std::string prompt_name = params["name"];
     
-    if (prompts_.find(prompt_name) == prompts_.end()) {
-        throw std::runtime_error("Prompt not found: " + prompt_name);
+    std::shared_ptr<const CatalogEntry<Prompt>> entry;
+    {
+        auto registry = registry_snapshot();
+        auto it = registry->prompts->entries.find(prompt_name);
+        if (it == registry->prompts->entries.end()) {
+            throw std::runtime_error("Prompt not found: " + prompt_name);
+        }
+        entry = it->second;
     }
     
-    json arguments = params.contains("arguments") ? params["arguments"] : json::object();
+    static const json no_arguments = json::object();
+    const json& arguments = params.contains("arguments") ? params["arguments"] : no_arguments;
     
     try {
-        json result = prompts_[prompt_name].function(arguments);
+        json result = entry->item.function(arguments);
         
         return {
-            {"description", prompts_[prompt_name].description},
-            {"messages", result}
+            {"description", entry->item.description},
+            {"messages", std::move(result)}
         };
     } catch (const std::exception& e) {
         throw std::runtime_error("Prompt execution failed: " + std::string(e.what()));
@@ -228,106 +774,522 @@ json MCPServer::handle_prompts_get(const json& params) {
 }
 
 json MCPServer::handle_message(const json& message) {
+    std::string response = handle_message_raw(message);
+    return response.empty() ? json() : json::parse(response);
+}
+
+std::string MCPServer::handle_message_raw(const json& message, const NotificationSink& notify) {
+    return dispatch_and_wait(default_session_, message, notify);
+}
+
+void MCPServer::handle_message_async(const json& message, ResponseCallback on_response,
+                                     NotificationSink notify) {
+    dispatch(default_session_, message, on_response, notify);
+}
+
+std::string MCPServer::handle_message_text(const std::string& text, const NotificationSink& notify) {
+    return dispatch_text(default_session_, text, notify);
+}
+
+void MCPServer::dispatch(const std::shared_ptr<Session>& session, const json& message,
+                         const ResponseCallback& on_response, const NotificationSink& notify) {
+    if (message.is_array()) {
+        handle_batch(session, message, notify, on_response);
+    } else {
+        handle_request(session, message, notify, on_response);
+    }
+}
+
+std::string MCPServer::dispatch_and_wait(const std::shared_ptr<Session>& session, const json& message,
+                                         const NotificationSink& notify) {
+    // Wait for asynchronous tools to complete
+    auto response = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = response->get_future();
+    dispatch(session, message, [response](std::string result) {
+        response->set_value(std::move(result));
+    }, notify);
+    return future.get();
+}
+
+std::string MCPServer::dispatch_text(const std::shared_ptr<Session>& session, const std::string& text,
+                                     const NotificationSink& notify) {
+    auto response = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = response->get_future();
+    dispatch_text(session, text, [response](std::string result) {
+        response->set_value(std::move(result));
+    }, notify);
+    return future.get();
+}
+
+void MCPServer::dispatch_text(const std::shared_ptr<Session>& session, const std::string& text,
+                              const ResponseCallback& on_response, const NotificationSink& notify) {
+    MessageEnvelope envelope;
+    if (lazy_parsing_ && scan_message(text, envelope)) {
+        handle_envelope(session, envelope, notify, on_response);
+    } else {
+        dispatch(session, json::parse(text), on_response, notify);
+    }
+}
+
+void MCPServer::handle_envelope(const std::shared_ptr<Session>& session, const MessageEnvelope& envelope,
+                                const NotificationSink& notify, const ResponseCallback& on_response) {
+    // Rebuild a small message document from the scanned members. For
+    // tools/call the arguments value is replaced by null and left as text.
+    json message = json::object();
+    std::string_view raw_arguments;
     try {
-        // Validate JSON-RPC 2.0 message
-        if (!message.contains("jsonrpc") || message["jsonrpc"] != "2.0") {
-            return create_error_response(-1, -32600, "Invalid JSON-RPC version");
-        }
+        auto parse = [](std::string_view token) { return json::parse(token.begin(), token.end()); };
+        if (!envelope.jsonrpc.empty()) message["jsonrpc"] = parse(envelope.jsonrpc);
+        if (!envelope.id.empty()) message["id"] = parse(envelope.id);
+        if (!envelope.method.empty()) message["method"] = parse(envelope.method);
         
-        if (!message.contains("method")) {
-            return create_error_response(-1, -32600, "Missing method");
+        if (!envelope.params.empty()) {
+            // Only splice arguments the scanner found inside these params
+            const char* params_begin = envelope.params.data();
+            const char* params_end = params_begin + envelope.params.size();
+            bool arguments_inside = !envelope.arguments.empty() &&
+                                    envelope.arguments.data() >= params_begin &&
+                                    envelope.arguments.data() + envelope.arguments.size() <= params_end;
+            if (arguments_inside && envelope.method == "\"tools/call\"") {
+                size_t offset = static_cast<size_t>(envelope.arguments.data() - envelope.params.data());
+                std::string params_text;
+                params_text.reserve(envelope.params.size() - envelope.arguments.size() + 4);
+                params_text.append(envelope.params.substr(0, offset));
+                params_text.append("null");
+                params_text.append(envelope.params.substr(offset + envelope.arguments.size()));
+                message["params"] = json::parse(params_text);
+                raw_arguments = envelope.arguments;
+            } else {
+                message["params"] = parse(envelope.params);
+            }
         }
+    } catch (const json::exception& e) {
+        on_response(serialize_error_response(nullptr, -32700, "Parse error: " + std::string(e.what())));
+        return;
+    } catch (const std::exception& e) {
+        on_response(serialize_error_response(nullptr, -32603, "Internal error: " + std::string(e.what())));
+        return;
+    }
+    
+    handle_request(session, message, notify, on_response, raw_arguments);
+}
+
+void MCPServer::handle_batch(const std::shared_ptr<Session>& session, const json& batch,
+                             const NotificationSink& notify, const ResponseCallback& on_response) {
+    if (batch.empty()) {
+        on_response(serialize_error_response(nullptr, -32600, "Invalid Request: empty batch"));
+        return;
+    }
+    
+    // Entries complete independently; the last one assembles the reply
+    struct BatchState {
+        std::vector<std::string> responses;
+        std::atomic<size_t> remaining;
+        ResponseCallback on_response;
+    };
+    auto state = std::make_shared<BatchState>();
+    state->responses.resize(batch.size());
+    state->remaining = batch.size();
+    state->on_response = on_response;
+    
+    auto handle_entry = [this, &session, &batch, &notify, state](size_t index) {
+        handle_request(session, batch[index], notify, [state, index](std::string response) {
+            state->responses[index] = std::move(response);
+            if (--state->remaining > 0) {
+                return;
+            }
+            
+            // Notifications contribute nothing; an all-notification batch gets no reply
+            std::string result = "[";
+            for (const auto& entry : state->responses) {
+                if (entry.empty()) continue;
+                if (result.size() > 1) result += ',';
+                result += entry;
+            }
+            
+            if (result.size() == 1) {
+                result.clear();
+            } else {
+                result += ']';
+            }
+            state->on_response(std::move(result));
+        });
+    };
+    
+    // Entries are independent, so fan them out across the worker pool
+    if (worker_pool_ && batch.size() > 1) {
+        worker_pool_->parallel_for(batch.size(), handle_entry);
+    } else {
+        for (size_t i = 0; i < batch.size(); ++i) {
+            handle_entry(i);
+        }
+    }
+}
+
+std::string MCPServer::finish_request(const json& id, bool is_notification,
+                                      const std::shared_ptr<CancellationToken>& token,
+                                      const std::string& result, std::exception_ptr error) {
+    // Stay silent for notifications and for requests the client cancelled
+    if (is_notification || (token && token->cancellation_requested())) {
+        return std::string();
+    }
+    
+    // Enforce the deadline even if the handler finished late
+    if (token && token->timed_out()) {
+        return serialize_error_response(id, -32001, "Request timed out");
+    }
+    
+    if (!error) {
+        return serialize_success_response(id, result);
+    }
+    
+    try {
+        std::rethrow_exception(error);
+    } catch (const JsonRpcError& e) {
+        return serialize_error_response(id, e.code(), e.what());
+    } catch (const json::exception& e) {
+        return serialize_error_response(id, -32700, "Parse error: " + std::string(e.what()));
+    } catch (const std::exception& e) {
+        return serialize_error_response(id, -32603, "Internal error: " + std::string(e.what()));
+    } catch (...) {
+        return serialize_error_response(id, -32603, "Internal error");
+    }
+}
+
+void MCPServer::handle_request(const std::shared_ptr<Session>& session, const json& message,
+                               const NotificationSink& notify, const ResponseCallback& on_response,
+                               std::string_view raw_arguments) {
+    // Requests without an id are notifications and never get a response
+    json id = message.is_object() && message.contains("id") ? message["id"] : json();
+    bool is_notification = message.is_object() && !message.contains("id");
+    
+    // Validate JSON-RPC 2.0 message
+    if (!message.is_object() || !message.contains("jsonrpc") || message["jsonrpc"] != "2.0") {
+        on_response(serialize_error_response(id, -32600, "Invalid JSON-RPC version"));
+        return;
+    }
+    
+    if (!message.contains("method") || !message["method"].is_string()) {
+        on_response(serialize_error_response(id, -32600, "Missing method"));
+        return;
+    }
+    
+    // Params are borrowed from the message, which outlives the synchronous
+    // part of the handler; nothing on the dispatch path copies them
+    const std::string& method = message["method"].get_ref<const std::string&>();
+    static const json no_params = json::object();
+    const json& params = message.contains("params") ? message["params"] : no_params;
+    
+    // Single hash lookup, independent of how many methods are registered
+    auto it = methods_.find(method);
+    if (it == methods_.end()) {
+        on_response(finish_request(id, is_notification, nullptr, std::string(),
+            std::make_exception_ptr(JsonRpcError(-32601, "Method not found: " + method))));
+        return;
+    }
+    
+    // Check if initialized for methods that need it
+    if (!session->initialized && it->second.requires_initialization) {
+        on_response(finish_request(id, is_notification, nullptr, std::string(),
+            std::make_exception_ptr(JsonRpcError(-32002, "Server not initialized"))));
+        return;
+    }
+    
+    // Track requests so notifications/cancelled can reach them
+    std::shared_ptr<CancellationToken> token;
+    std::string key;
+    if (!is_notification) {
+        token = std::make_shared<CancellationToken>();
         
-        std::string method = message["method"];
-        json params = message.contains("params") ? message["params"] : json::object();
-        int id = message.contains("id") ? message["id"].get<int>() : -1;
-        
-        // Handle initialization
-        if (method == "initialize") {
-            json result = handle_initialize(params);
-            return create_success_response(id, result);
+        // Clients may bound a request with _meta.timeoutMs
+        if (params.is_object() && params.contains("_meta") && params["_meta"].is_object()) {
+            json timeout = params["_meta"].value("timeoutMs", json());
+            double ms = timeout.is_number() ? timeout.get<double>() : -1;
+            if (std::isfinite(ms) && ms >= 0) {
+                ms = std::min(ms, static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(kMaxRequestTimeout).count()));
+                token->set_deadline(CancellationToken::Clock::now() +
+                                    std::chrono::milliseconds(static_cast<int64_t>(ms)));
+            }
         }
         
-        // Check if initialized for other methods
-        if (!initialized_ && method != "initialize") {
-            return create_error_response(id, -32002, "Server not initialized");
+        key = id.dump(-1, ' ', false, json::error_handler_t::replace);
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->in_flight[key] = token;
+    }
+    
+    // Clients opt into progress notifications with _meta.progressToken
+    json progress_token;
+    if (params.is_object() && params.contains("_meta") && params["_meta"].is_object()) {
+        progress_token = params["_meta"].value("progressToken", json());
+    }
+    
+    auto context = std::make_shared<RequestContext>(id, token, std::move(progress_token), notify);
+    RequestContext::Scope scope(context.get());
+    
+    // Asynchronous handlers call this later, possibly on another thread.
+    // A deadline timer may answer first; whichever comes second is dropped.
+    struct Completion {
+        std::atomic<bool> answered{false};
+        std::atomic<EventLoop::TimerId> deadline_timer{0};
+    };
+    auto completion = std::make_shared<Completion>();
+    MethodCompletion done = [this, session, id, is_notification, key, token, on_response, completion]
+                            (std::string result, std::exception_ptr error) {
+        if (completion->answered.exchange(true)) {
+            return;
+        }
+        if (EventLoop::TimerId timer = completion->deadline_timer.load()) {
+            event_loop_->cancel_timer(timer);
+        }
+        untrack_request(*session, key, token);
+        on_response(finish_request(id, is_notification, token, result, error));
+    };
+    
+    const MethodEntry& entry = it->second;
+    if (entry.async_handler) {
+        // A handler that throws hasn't started anything that could complete
+        try {
+            entry.async_handler(params, raw_arguments, context, done);
+        } catch (...) {
+            done(std::string(), std::current_exception());
         }
         
-        // Route to appropriate handler
-        json result;
-        if (method == "tools/list") {
-            result = handle_tools_list(params);
-        } else if (method == "tools/call") {
-            result = handle_tools_call(params);
-        } else if (method == "resources/list") {
-            result = handle_resources_list(params);
-        } else if (method == "resources/read") {
-            result = handle_resources_read(params);
-        } else if (method == "prompts/list") {
-            result = handle_prompts_list(params);
-        } else if (method == "prompts/get") {
-            result = handle_prompts_get(params);
+        // Still running: answer with the timeout error once the deadline
+        // passes, instead of whenever the handler gets around to finishing
+        if (token && token->has_deadline() && !completion->answered) {
+            EventLoop::TimerId timer = event_loop().add_timer_at(token->deadline(), [token, done] {
+                if (token->timed_out()) {
+                    done(std::string(), nullptr);
+                }
+            });
+            completion->deadline_timer = timer;
+            if (completion->answered) {
+                event_loop_->cancel_timer(timer);
+            }
+        }
+        return;
+    }
+    
+    std::string result;
+    std::exception_ptr error;
+    try {
+        if (entry.session_handler) {
+            result = entry.session_handler(*session, params).dump();
         } else {
-            return create_error_response(id, -32601, "Method not found: " + method);
+            result = entry.raw_handler ? entry.raw_handler(params) : entry.handler(params).dump();
         }
-        
-        return create_success_response(id, result);
-        
-    } catch (const json::exception& e) {
-        return create_error_response(-1, -32700, "Parse error: " + std::string(e.what()));
-    } catch (const std::exception& e) {
-        int id = message.contains("id") ? message["id"].get<int>() : -1;
-        return create_error_response(id, -32603, "Internal error: " + std::string(e.what()));
+    } catch (...) {
+        error = std::current_exception();
     }
+    done(std::move(result), error);
 }
 
-std::string MCPServer::read_stdio_message() {
-    std::string line;
-    std::getline(std::cin, line);
-    return line;
-}
-
-void MCPServer::write_stdio_message(const std::string& message) {
-    std::cout << message << std::endl;
-    std::cout.flush();
+void MCPServer::untrack_request(Session& session, const std::string& key,
+                                const std::shared_ptr<CancellationToken>& token) {
+    if (!token) {
+        return;
+    }
+    
+    // Only remove our own entry; a reused id may belong to a newer request
+    std::lock_guard<std::mutex> lock(session.mutex);
+    auto it = session.in_flight.find(key);
+    if (it != session.in_flight.end() && it->second == token) {
+        session.in_flight.erase(it);
+    }
 }
 
-void MCPServer::run_stdio_loop() {
+void MCPServer::run_stdio_loop(StdioTransport& transport) {
     std::cerr << "MCP Server '" << server_name_ << "' starting in STDIO mode..." << std::endl;
     
-    while (std::cin) {
+    // Each run is its own client, initialized by its own handshake
+    auto session = std::make_shared<Session>();
+    
+    // Progress and other notifications share stdout with responses. A tool
+    // answered by its deadline may still report after the run has ended
+    // and the transport is gone; its notifications are then dropped.
+    struct Output {
+        std::mutex mutex;
+        StdioTransport* transport;  // Null once the run has ended
+    };
+    auto output = std::make_shared<Output>();
+    output->transport = &transport;
+    NotificationSink notify = [output](const std::string& notification) {
+        std::lock_guard<std::mutex> lock(output->mutex);
+        if (output->transport) {
+            output->transport->write(notification);
+        }
+    };
+    int broadcast_sink = add_broadcast_sink(notify, session);
+    
+    // Responses may be written after the reader has moved on (worker
+    // threads, asynchronous tools); count them so EOF waits for all
+    std::mutex pending_mutex;
+    std::condition_variable pending_cv;
+    size_t pending = 0;
+    ResponseCallback respond = [&](std::string response) {
+        if (!response.empty()) {
+            transport.write(std::move(response));
+        }
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        --pending;
+        pending_cv.notify_all();
+    };
+    
+    while (true) {
+        // Responses to messages that arrived together are written together:
+        // output is held while more input is buffered and sent before the
+        // reader blocks for more
+        if (!transport.has_buffered_message()) {
+            transport.uncork();
+        }
+        
+        // A client that doesn't read its responses stops being read from
+        transport.wait_for_capacity();
+        
+        // JSON built while reading and dispatching this message comes from
+        // the thread's arena, rewound once the iteration is done
+        JsonArena::RequestScope arena_scope;
+        
         try {
-            std::string input = read_stdio_message();
+            // Kept on the heap: a scanned envelope points into the text
+            auto input = std::make_shared<std::string>();
+            MessageLimiter limiter(max_message_bytes_, max_message_depth_);
+            if (!transport.read(*input, limiter)) {
+                break;
+            }
+            transport.cork();
             
-            if (input.empty()) {
+            if (input->empty()) {
                 continue;
             }
             
-            // Parse JSON
-            json request = json::parse(input);
+            // With lazy parsing, route from a scan of the envelope; batches
+            // and anything the scanner declines get a full parse
+            auto envelope = std::make_shared<MessageEnvelope>();
+            bool scanned = lazy_parsing_ && scan_message(*input, *envelope);
+            
+            std::shared_ptr<json> request;
+            bool inline_only;
+            if (scanned) {
+                inline_only = envelope->id.empty() || envelope->method == "\"initialize\"";
+            } else {
+                request = std::make_shared<json>(json::parse(*input));
+                
+                // Hand requests to the worker pool; initialize and notifications
+                // stay on the reader thread so they take effect in order
+                inline_only = request->is_object() &&
+                              (!request->contains("id") || request->value("method", "") == "initialize");
+            }
+            
+            // Answered exactly once, even when handling throws, so pending
+            // always comes back down
+            auto answered = std::make_shared<std::atomic<bool>>(false);
+            ResponseCallback reply = [answered, respond](std::string response) {
+                if (!answered->exchange(true)) {
+                    respond(std::move(response));
+                }
+            };
             
-            // Handle message
-            json response = handle_message(request);
+            // Handle message; asynchronous tools respond when they complete
+            auto handle = [this, session, input, envelope, request, notify, reply]() {
+                try {
+                    if (request) {
+                        dispatch(session, *request, reply, notify);
+                    } else {
+                        handle_envelope(session, *envelope, notify, reply);
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    reply(serialize_error_response(nullptr, -32603, "Internal error: " + std::string(e.what())));
+                }
+            };
             
-            // Send response
-            write_stdio_message(response.dump());
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex);
+                ++pending;
+            }
             
+            if (worker_pool_ && !inline_only) {
+                try {
+                    worker_pool_->submit([handle]() {
+                        JsonArena::RequestScope arena_scope;
+                        handle();
+                    });
+                } catch (...) {
+                    reply(std::string());
+                    throw;
+                }
+                continue;
+            }
+            
+            handle();
+            
+        } catch (const MessageLimitError& e) {
+            std::cerr << "Rejected message: " << e.what() << std::endl;
+            transport.write(serialize_error_response(nullptr, -32600, e.what()));
         } catch (const json::exception& e) {
             std::cerr << "JSON error: " << e.what() << std::endl;
-            json error = create_error_response(-1, -32700, "Parse error");
-            write_stdio_message(error.dump());
+            transport.write(serialize_error_response(nullptr, -32700, "Parse error"));
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
         }
     }
+    
+    // Let in-flight requests finish before returning
+    transport.uncork();
+    {
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        pending_cv.wait(lock, [&pending] { return pending == 0; });
+    }
+    if (worker_pool_) {
+        worker_pool_->wait_idle();
+    }
+    remove_broadcast_sink(broadcast_sink);
+    std::lock_guard<std::mutex> lock(output->mutex);
+    output->transport = nullptr;
 }
 
 void MCPServer::run_stdio() {
-    run_stdio_loop();
+    run_stdio(STDIN_FILENO, STDOUT_FILENO);
+}
+
+void MCPServer::run_stdio(int in_fd, int out_fd) {
+    StdioTransport transport(event_loop(), in_fd, out_fd, stdio_framing_, max_queued_output_);
+    run_stdio_loop(transport);
 }
 
 void MCPServer::run_sse(int port) {
     run_sse_server(port);
 }
 
+bool MCPServer::start_sse(int port) {
+    stop_sse();
+    
+    // Wait until the port is bound, so a failure is reported here
+    auto bound = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = bound->get_future();
+    sse_thread_ = std::thread([this, port, bound] {
+        run_sse_server(port, [&bound](bool ok) { bound->set_value(ok); });
+    });
+    
+    if (!result.get()) {
+        sse_thread_.join();
+        return false;
+    }
+    return true;
+}
+
+void MCPServer::stop_sse() {
+    {
+        std::lock_guard<std::mutex> lock(sse_mutex_);
+        if (stop_sse_) {
+            stop_sse_();
+        }
+    }
+    if (sse_thread_.joinable()) {
+        sse_thread_.join();
+    }
+}
+
 } // namespace mcp
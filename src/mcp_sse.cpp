@@ -1,34 +1,109 @@
 #include <cppmcp/mcp_server.hpp>
+#include <cppmcp/event_loop.hpp>
+#include <cppmcp/json_arena.hpp>
+#include <cppmcp/json_scanner.hpp>
+#include <cppmcp/message_encoding.hpp>
+#include <cppmcp/message_limits.hpp>
 #include <httplib.h>
 #include <iostream>
+#include <memory>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <cstdio>
+#include <random>
+#include <set>
 
 namespace mcp {
 
-// SSE connection state
+// Serialized message, shared by every stream and response it is sent on
+using SharedMessage = std::shared_ptr<const std::string>;
+
+// Time between keepalives on an idle SSE stream, and how many idle
+// periods pass before the stream is closed
+static const std::chrono::seconds kKeepaliveInterval(10);
+static const int kMaxIdlePeriods = 3;
+
+// Sessions one HTTP server keeps for its clients, beyond the anonymous
+// one, and how long a session without requests or an open stream lasts
+static const size_t kMaxSessions = 1024;
+static const std::chrono::minutes kSessionIdleTimeout(30);
+
+// Unguessable Mcp-Session-Id: 128 random bits in hex
+static std::string generate_session_id() {
+    thread_local std::mt19937_64 random(std::random_device{}());
+    char id[33];
+    std::snprintf(id, sizeof(id), "%016llx%016llx",
+                  static_cast<unsigned long long>(random()), static_cast<unsigned long long>(random()));
+    return id;
+}
+
+// SSE connection state. A null message in the queue stands for a keepalive.
 struct SSEConnection {
-    std::queue<std::string> message_queue;
+    // The client's session has been initialized; shares ownership of it
+    std::shared_ptr<const std::atomic<bool>> initialized;
+    std::queue<SharedMessage> message_queue;
     std::mutex mutex;
     std::condition_variable cv;
     std::atomic<bool> active{true};
+    int idle_periods = 0;  // Guarded by mutex
 };
 
-void MCPServer::run_sse_server(int port) {
+void MCPServer::run_sse_server(int port, const std::function<void(bool bound)>& on_bound) {
     std::cerr << "MCP Server '" << server_name_ << "' starting in SSE mode on port " << port << "..." << std::endl;
     std::cerr << "Using Streamable HTTP transport (MCP 2024-11-05+)" << std::endl;
     
     httplib::Server server;
     
+    // Bodies with a larger Content-Length are refused before being read
+    if (max_message_bytes_ != 0) {
+        server.set_payload_max_length(max_message_bytes_);
+    }
+    
     // Store active SSE connections per session
     std::map<std::string, std::shared_ptr<SSEConnection>> connections;
     std::mutex connections_mutex;
     
-    // Store session state
-    std::map<std::string, bool> sessions;
+    // Per-client protocol state, keyed by the Mcp-Session-Id the server
+    // assigned on initialize. Clients that send no session id share the
+    // anonymous session, which any such initialize also initializes.
+    struct HttpSession {
+        std::shared_ptr<Session> session;
+        EventLoop::Clock::time_point last_active;
+    };
+    std::map<std::string, HttpSession> sessions;
     std::mutex sessions_mutex;
+    auto anonymous_session = std::make_shared<Session>();
+    
+    // Null for an id this server didn't assign, or one that has expired
+    // or been deleted
+    auto find_session = [&](const std::string& session_id) -> std::shared_ptr<Session> {
+        if (session_id.empty()) {
+            return anonymous_session;
+        }
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        auto it = sessions.find(session_id);
+        if (it == sessions.end()) {
+            return nullptr;
+        }
+        it->second.last_active = EventLoop::Clock::now();
+        return it->second.session;
+    };
+    
+    // Sets session_id to a new id; null once kMaxSessions are held
+    auto create_session = [&](std::string& session_id) -> std::shared_ptr<Session> {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        if (sessions.size() >= kMaxSessions) {
+            return nullptr;
+        }
+        do {
+            session_id = generate_session_id();
+        } while (sessions.count(session_id) != 0);
+        auto session = std::make_shared<Session>();
+        sessions[session_id] = HttpSession{session, EventLoop::Clock::now()};
+        return session;
+    };
     
     // Connection cleanup helper
     auto cleanup_stale_connections = [&connections, &connections_mutex]() {
@@ -45,6 +120,93 @@ void MCPServer::run_sse_server(int port) {
         std::cerr << "Active connections: " << connections.size() << std::endl;
     };
     
+    // Sinks handed to tools can outlive this function; they check that
+    // the streams are still open before touching them
+    struct StreamsOpen {
+        std::mutex mutex;
+        bool open = true;  // Guarded by mutex
+    };
+    auto streams_open = std::make_shared<StreamsOpen>();
+    
+    // Notifications emitted while handling a POST (e.g. progress) go to the
+    // session's SSE stream, or to every stream when no session is given
+    auto make_notification_sink = [&connections, &connections_mutex, streams_open](const std::string& session_id) {
+        return NotificationSink([&connections, &connections_mutex, streams_open,
+                                 session_id](const std::string& notification) {
+            std::lock_guard<std::mutex> open_lock(streams_open->mutex);
+            if (!streams_open->open) {
+                return;
+            }
+            auto message = std::make_shared<const std::string>(notification);
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            for (auto& [id, conn] : connections) {
+                if (!session_id.empty() && id != session_id) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> conn_lock(conn->mutex);
+                conn->message_queue.push(message);
+                conn->cv.notify_one();
+            }
+        });
+    };
+    
+    // Server-initiated notifications only go to streams whose session has
+    // completed its handshake
+    auto broadcast_notification = [&connections, &connections_mutex](const std::string& notification) {
+        auto message = std::make_shared<const std::string>(notification);
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (auto& [id, conn] : connections) {
+            if (!*conn->initialized) {
+                continue;
+            }
+            std::lock_guard<std::mutex> conn_lock(conn->mutex);
+            conn->message_queue.push(message);
+            conn->cv.notify_one();
+        }
+    };
+    
+    // Responses go to the session's SSE stream, or every stream when no
+    // session is given, as well as the POST that asked
+    auto broadcast_response = [&connections, &connections_mutex](const std::string& session_id,
+                                                                 const SharedMessage& response) {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (auto& [id, conn] : connections) {
+            if (!session_id.empty() && id != session_id) {
+                continue;
+            }
+            std::lock_guard<std::mutex> conn_lock(conn->mutex);
+            conn->message_queue.push(response);
+            conn->cv.notify_one();
+        }
+    };
+    
+    // Responses to the old transport's POSTs reach the session's stream
+    // when the request completes, which may be after the POST was answered
+    auto make_stream_reply = [&broadcast_response, streams_open](const std::string& session_id) {
+        return ResponseCallback([&broadcast_response, streams_open, session_id](std::string response) {
+            std::lock_guard<std::mutex> open_lock(streams_open->mutex);
+            if (!streams_open->open || response.empty()) {
+                return;
+            }
+            broadcast_response(session_id, std::make_shared<const std::string>(std::move(response)));
+        });
+    };
+    
+    auto has_stream = [&connections, &connections_mutex](const std::string& session_id) {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        auto it = connections.find(session_id);
+        return it != connections.end() && it->second->active;
+    };
+    
+    // The HTTP body is served from the shared buffer rather than a copy
+    auto send_shared = [](httplib::Response& res, SharedMessage response) {
+        size_t size = response->size();
+        res.set_content_provider(size, "application/json",
+            [response = std::move(response)](size_t offset, size_t length, httplib::DataSink& sink) {
+                return sink.write(response->data() + offset, length);
+            });
+    };
+    
     // Health check endpoint (optional, not part of MCP spec)
     server.Get("/health", [&cleanup_stale_connections](const httplib::Request&, httplib::Response& res) {
         cleanup_stale_connections();  // Clean up on health checks
@@ -90,24 +252,41 @@ void MCPServer::run_sse_server(int port) {
             }
         }
         
-        // Generate connection ID (or use session ID if provided)
-        std::string session_id = req.get_header_value("Mcp-Session-Id");
-        std::string connection_id;
-        
-        if (!session_id.empty()) {
-            connection_id = session_id;
+        // The stream belongs to the client's session. A stream opened
+        // without one starts a session of its own, named in the endpoint
+        // event for the old HTTP+SSE transport.
+        std::string connection_id = req.get_header_value("Mcp-Session-Id");
+        std::shared_ptr<Session> session;
+        if (!connection_id.empty()) {
+            session = find_session(connection_id);
+            if (!session) {
+                res.status = 404;
+                res.set_content("Not Found: Unknown session", "text/plain");
+                return;
+            }
         } else {
-            // Use timestamp + random to avoid collisions
-            connection_id = std::to_string(std::hash<std::string>{}(
-                req.remote_addr + std::to_string(time(nullptr)) + std::to_string(rand())
-            ));
+            session = create_session(connection_id);
+            if (!session) {
+                res.status = 503;
+                res.set_content("Service Unavailable: Too many sessions", "text/plain");
+                return;
+            }
         }
         
         auto conn = std::make_shared<SSEConnection>();
+        conn->initialized = std::shared_ptr<const std::atomic<bool>>(session, &session->initialized);
         
         {
+            // A reconnecting client replaces its old stream, which nothing
+            // else could reach once it leaves the map
             std::lock_guard<std::mutex> lock(connections_mutex);
-            connections[connection_id] = conn;
+            auto& slot = connections[connection_id];
+            if (slot) {
+                std::lock_guard<std::mutex> conn_lock(slot->mutex);
+                slot->active = false;
+                slot->cv.notify_all();
+            }
+            slot = conn;
             std::cerr << "SSE client connected (GET): " << connection_id 
                       << " (total: " << connections.size() << ")" << std::endl;
         }
@@ -125,53 +304,36 @@ void MCPServer::run_sse_server(int port) {
                 // Send initial endpoint event for old HTTP+SSE transport compatibility
                 // This tells the client where to POST messages
                 if (offset == 0) {
-                    std::string endpoint_event = "event: endpoint\ndata: /message\n\n";
+                    std::string endpoint_event = "event: endpoint\ndata: /message?sessionId=" + connection_id + "\n\n";
                     sink.write(endpoint_event.c_str(), endpoint_event.size());
                     std::cerr << "Sent endpoint event to client: " << connection_id << std::endl;
                 }
                 
-                // Shorter timeout to detect disconnections faster
-                int idle_count = 0;
-                const int max_idle = 3;  // Max 3 idle periods before checking
-                
+                // Keepalives and the idle timeout come from the event loop's
+                // timer, so the stream only wakes when there is something to send
                 while (conn->active) {
                     std::unique_lock<std::mutex> lock(conn->mutex);
+                    conn->cv.wait(lock, [&conn] { return !conn->message_queue.empty() || !conn->active; });
                     
-                    // Wait for messages or timeout (shorter: 10 seconds)
-                    if (conn->cv.wait_for(lock, std::chrono::seconds(10),
-                                         [&conn] { return !conn->message_queue.empty() || !conn->active; })) {
-                        
-                        if (!conn->active) break;
-                        
-                        idle_count = 0;  // Reset idle counter
+                    while (conn->active && !conn->message_queue.empty()) {
+                        SharedMessage message = std::move(conn->message_queue.front());
+                        conn->message_queue.pop();
                         
-                        while (!conn->message_queue.empty()) {
-                            std::string message = conn->message_queue.front();
-                            conn->message_queue.pop();
-                            
-                            // Format as SSE
-                            std::string sse_message = "data: " + message + "\n\n";
-                            if (!sink.write(sse_message.c_str(), sse_message.size())) {
-                                std::cerr << "Failed to write to SSE sink, client disconnected: " 
-                                          << connection_id << std::endl;
-                                conn->active = false;
-                                break;
-                            }
-                        }
-                    } else {
-                        // Timeout - send keepalive or close if too many idles
-                        idle_count++;
-                        if (idle_count >= max_idle) {
-                            std::cerr << "Connection idle timeout, closing: " << connection_id << std::endl;
-                            conn->active = false;
-                            break;
+                        // Format as SSE
+                        std::string sse_message;
+                        if (message) {
+                            conn->idle_periods = 0;
+                            sse_message.reserve(message->size() + 8);
+                            sse_message += "data: ";
+                            sse_message += *message;
+                            sse_message += "\n\n";
+                        } else {
+                            sse_message = ":keepalive\n\n";
                         }
-                        
-                        std::string keepalive = ":keepalive\n\n";
-                        if (!sink.write(keepalive.c_str(), keepalive.size())) {
-                            std::cerr << "Keepalive failed, client disconnected: " << connection_id << std::endl;
+                        if (!sink.write(sse_message.c_str(), sse_message.size())) {
+                            std::cerr << "Failed to write to SSE sink, client disconnected: " 
+                                      << connection_id << std::endl;
                             conn->active = false;
-                            break;
                         }
                     }
                 }
@@ -184,8 +346,12 @@ void MCPServer::run_sse_server(int port) {
                 conn->cv.notify_all();
                 
                 {
+                    // Leave a stream that replaced this one in place
                     std::lock_guard<std::mutex> lock(connections_mutex);
-                    connections.erase(connection_id);
+                    auto it = connections.find(connection_id);
+                    if (it != connections.end() && it->second == conn) {
+                        connections.erase(it);
+                    }
                 }
                 
                 std::cerr << "SSE client disconnected: " << connection_id << std::endl;
@@ -193,88 +359,207 @@ void MCPServer::run_sse_server(int port) {
         );
     });
     
-    // Main MCP endpoint - POST method for requests
-    server.Post("/", [&](const httplib::Request& req, httplib::Response& res) {
-        // Set CORS headers
-        res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Methods", "POST, GET, OPTIONS");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type, Mcp-Session-Id");
+    // Handle a POSTed JSON-RPC message. The request body may be JSON, CBOR
+    // or MessagePack (Content-Type); the response uses the binary encoding
+    // named in Accept, else JSON. SSE streams always carry JSON. Legacy
+    // posts to /message name their session in the sessionId parameter.
+    auto handle_post = [&](const httplib::Request& req, httplib::Response& res,
+                           const httplib::ContentReader& content_reader, bool legacy) {
+        MessageEncoding request_encoding = encoding_from_content_type(req.get_header_value("Content-Type"));
+        MessageEncoding response_encoding = encoding_from_accept(req.get_header_value("Accept"));
+        
+        // Request documents come from this connection thread's arena
+        JsonArena::RequestScope arena_scope;
         
         try {
-            // Parse incoming JSON-RPC message
-            json request = json::parse(req.body);
+            // Read the body as it arrives and stop at the first limit it
+            // exceeds. Binary bodies are checked for depth when decoded.
+            size_t max_depth = max_message_depth_;
+            MessageLimiter limiter(max_message_bytes_, max_depth);
+            std::string body;
+            bool within_limits = true;
+            bool complete = content_reader([&](const char* data, size_t length) {
+                within_limits = request_encoding == MessageEncoding::JSON ? limiter.feed(data, length)
+                                                                          : limiter.feed_bytes(length);
+                if (within_limits) {
+                    body.append(data, length);
+                }
+                return within_limits;
+            });
+            if (!within_limits) {
+                throw limiter.error();
+            }
+            if (!complete) {
+                // httplib skips a body whose Content-Length is over the payload limit
+                if (res.status == 413) {
+                    throw MessageLimitError::too_large(max_message_bytes_);
+                }
+                throw std::runtime_error("Failed to read request body");
+            }
             
-            // Handle the request
-            json response = handle_message(request);
+            // Binary bodies are decoded here, JSON is routed from its text
+            json decoded;
+            if (request_encoding != MessageEncoding::JSON) {
+                decoded = decode_message(body, request_encoding, max_depth);
+            }
             
-            // For old HTTP+SSE transport, always return JSON response
-            res.set_content(response.dump(), "application/json");
+            // A client without a session gets one by initializing; other
+            // requests without one go to the anonymous session
+            std::string session_id = req.get_header_value("Mcp-Session-Id");
+            if (legacy && session_id.empty()) {
+                session_id = req.get_param_value("sessionId");
+            }
+            std::shared_ptr<Session> session;
+            bool new_session = false;
+            if (!session_id.empty()) {
+                session = find_session(session_id);
+                if (!session) {
+                    json error = create_error_response(nullptr, -32600, "Unknown session");
+                    res.set_content(encode_message(error, response_encoding), content_type(response_encoding));
+                    res.status = 404;
+                    return;
+                }
+            } else {
+                bool initialize;
+                if (request_encoding == MessageEncoding::JSON) {
+                    MessageEnvelope envelope;
+                    initialize = scan_message(body, envelope) && envelope.method == "\"initialize\"";
+                } else {
+                    initialize = decoded.is_object() && decoded.contains("method") &&
+                                 decoded["method"] == "initialize";
+                }
+                session = initialize ? create_session(session_id) : anonymous_session;
+                if (!session) {
+                    json error = create_error_response(nullptr, -32603, "Too many sessions");
+                    res.set_content(encode_message(error, response_encoding), content_type(response_encoding));
+                    res.status = 503;
+                    return;
+                }
+                if (initialize) {
+                    res.set_header("Mcp-Session-Id", session_id);
+                    new_session = true;
+                }
+            }
             
-            // Also broadcast via SSE if there are active connections
-            std::string response_str = response.dump();
-            {
-                std::lock_guard<std::mutex> lock(connections_mutex);
-                for (auto& [id, conn] : connections) {
-                    std::lock_guard<std::mutex> conn_lock(conn->mutex);
-                    conn->message_queue.push(response_str);
-                    conn->cv.notify_one();
+            // Parse and handle the incoming JSON-RPC message
+            NotificationSink notify = make_notification_sink(session_id);
+            
+            // With the old transport the answer goes on the session's open
+            // stream, so the POST is accepted at once and a long-running
+            // asynchronous tool doesn't hold this connection's thread
+            if (legacy && !session_id.empty() && has_stream(session_id)) {
+                ResponseCallback reply = make_stream_reply(session_id);
+                if (request_encoding == MessageEncoding::JSON) {
+                    dispatch_text(session, body, reply, notify);
+                } else {
+                    dispatch(session, decoded, reply, notify);
+                }
+                res.status = 202;
+                return;
+            }
+            
+            auto response = std::make_shared<const std::string>(
+                request_encoding == MessageEncoding::JSON
+                    ? dispatch_text(session, body, notify)
+                    : dispatch_and_wait(session, decoded, notify));
+            
+            // Clients that don't echo Mcp-Session-Id send their later
+            // requests to the anonymous session, so the handshake that
+            // created a session initializes that one as well
+            if (new_session && session->initialized) {
+                json client_info;
+                {
+                    std::lock_guard<std::mutex> lock(session->mutex);
+                    client_info = session->client_info;
                 }
+                std::lock_guard<std::mutex> lock(anonymous_session->mutex);
+                anonymous_session->client_info = std::move(client_info);
+                anonymous_session->initialized = true;
+            }
+            
+            // Notifications have no response
+            if (response->empty()) {
+                res.status = 202;
+                return;
+            }
+            
+            // Also broadcast via SSE if there are active connections
+            broadcast_response(session_id, response);
+            
+            if (response_encoding == MessageEncoding::JSON) {
+                send_shared(res, std::move(response));
+            } else {
+                res.set_content(encode_message_text(*response, response_encoding),
+                                content_type(response_encoding));
             }
             
+        } catch (const MessageLimitError& e) {
+            json error = create_error_response(nullptr, -32600, e.what());
+            res.set_content(encode_message(error, response_encoding), content_type(response_encoding));
+            res.status = e.size_exceeded() ? 413 : 400;
         } catch (const json::exception& e) {
-            json error = create_error_response(-1, -32700, "Parse error: " + std::string(e.what()));
-            res.set_content(error.dump(), "application/json");
+            json error = create_error_response(nullptr, -32700, "Parse error: " + std::string(e.what()));
+            res.set_content(encode_message(error, response_encoding), content_type(response_encoding));
             res.status = 400;
         } catch (const std::exception& e) {
-            json error = create_error_response(-1, -32603, "Internal error: " + std::string(e.what()));
-            res.set_content(error.dump(), "application/json");
+            json error = create_error_response(nullptr, -32603, "Internal error: " + std::string(e.what()));
+            res.set_content(encode_message(error, response_encoding), content_type(response_encoding));
             res.status = 500;
         }
+    };
+    
+    // Main MCP endpoint - POST method for requests
+    server.Post("/", [&](const httplib::Request& req, httplib::Response& res,
+                         const httplib::ContentReader& content_reader) {
+        // Set CORS headers
+        res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_header("Access-Control-Allow-Methods", "POST, GET, OPTIONS");
+        res.set_header("Access-Control-Allow-Headers", "Content-Type, Mcp-Session-Id");
+        res.set_header("Access-Control-Expose-Headers", "Mcp-Session-Id");
+        
+        handle_post(req, res, content_reader, false);
     });
     
     // Legacy /message endpoint for old HTTP+SSE transport compatibility
-    server.Post("/message", [&](const httplib::Request& req, httplib::Response& res) {
+    server.Post("/message", [&](const httplib::Request& req, httplib::Response& res,
+                                const httplib::ContentReader& content_reader) {
         // Set CORS headers
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_header("Access-Control-Allow-Methods", "POST, OPTIONS");
         res.set_header("Access-Control-Allow-Headers", "Content-Type");
         
-        try {
-            // Parse incoming JSON-RPC message
-            json request = json::parse(req.body);
-            
-            // Handle the request
-            json response = handle_message(request);
-            
-            // Return JSON response
-            res.set_content(response.dump(), "application/json");
-            
-            // Also broadcast via SSE if there are active connections
-            std::string response_str = response.dump();
-            {
-                std::lock_guard<std::mutex> lock(connections_mutex);
-                for (auto& [id, conn] : connections) {
-                    std::lock_guard<std::mutex> conn_lock(conn->mutex);
-                    conn->message_queue.push(response_str);
-                    conn->cv.notify_one();
-                }
+        handle_post(req, res, content_reader, true);
+    });
+    
+    // A client ends its session with DELETE; its stream is closed and a
+    // later request with the same id starts over uninitialized
+    server.Delete("/", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_header("Access-Control-Allow-Origin", "*");
+        std::string session_id = req.get_header_value("Mcp-Session-Id");
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            if (session_id.empty() || sessions.erase(session_id) == 0) {
+                res.status = 404;
+                return;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            auto it = connections.find(session_id);
+            if (it != connections.end()) {
+                std::lock_guard<std::mutex> conn_lock(it->second->mutex);
+                it->second->active = false;
+                it->second->cv.notify_all();
             }
-            
-        } catch (const json::exception& e) {
-            json error = create_error_response(-1, -32700, "Parse error: " + std::string(e.what()));
-            res.set_content(error.dump(), "application/json");
-            res.status = 400;
-        } catch (const std::exception& e) {
-            json error = create_error_response(-1, -32603, "Internal error: " + std::string(e.what()));
-            res.set_content(error.dump(), "application/json");
-            res.status = 500;
         }
+        std::cerr << "Session ended: " << session_id << std::endl;
+        res.status = 204;
     });
     
     // CORS preflight
     server.Options("/", [](const httplib::Request&, httplib::Response& res) {
         res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Methods", "POST, GET, OPTIONS");
+        res.set_header("Access-Control-Allow-Methods", "POST, GET, DELETE, OPTIONS");
         res.set_header("Access-Control-Allow-Headers", "Content-Type, Mcp-Session-Id, Accept");
         res.status = 204;
     });
@@ -286,6 +571,15 @@ void MCPServer::run_sse_server(int port) {
         res.status = 204;
     });
     
+    // Bind to localhost only for security
+    if (!server.bind_to_port("127.0.0.1", port)) {
+        std::cerr << "Failed to bind port " << port << std::endl;
+        if (on_bound) {
+            on_bound(false);
+        }
+        return;
+    }
+    
     std::cerr << "Server listening on http://localhost:" << port << std::endl;
     std::cerr << "MCP endpoint: http://localhost:" << port << "/" << std::endl;
     std::cerr << "Legacy endpoint: http://localhost:" << port << "/message" << std::endl;
@@ -294,7 +588,97 @@ void MCPServer::run_sse_server(int port) {
     std::cerr << "\nTo test with MCP SDK client:" << std::endl;
     std::cerr << "  python test_mcp_sse.py --url http://localhost:" << port << std::endl;
     
-    server.listen("127.0.0.1", port);  // Bind to localhost only for security
+    // One timer for every stream: idle streams get a keepalive, streams
+    // idle too long are closed, and closed ones are dropped. Sessions with
+    // neither requests nor an open stream for kSessionIdleTimeout expire.
+    EventLoop& loop = event_loop();
+    std::atomic<EventLoop::TimerId> keepalive_timer{0};
+    bool stopped = false;  // Read and written on the loop thread
+    std::function<void()> keepalive = [&]() {
+        if (stopped) {
+            return;
+        }
+        std::set<std::string> streaming;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            for (auto it = connections.begin(); it != connections.end();) {
+                auto& conn = it->second;
+                {
+                    std::lock_guard<std::mutex> conn_lock(conn->mutex);
+                    if (++conn->idle_periods >= kMaxIdlePeriods) {
+                        std::cerr << "Connection idle timeout, closing: " << it->first << std::endl;
+                        conn->active = false;
+                    } else if (conn->active) {
+                        conn->message_queue.push(nullptr);
+                    }
+                    conn->cv.notify_one();
+                }
+                if (conn->active) {
+                    streaming.insert(it->first);
+                    ++it;
+                } else {
+                    it = connections.erase(it);
+                }
+            }
+        }
+        {
+            auto now = EventLoop::Clock::now();
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            for (auto it = sessions.begin(); it != sessions.end();) {
+                if (streaming.count(it->first) != 0) {
+                    it->second.last_active = now;
+                } else if (now - it->second.last_active >= kSessionIdleTimeout) {
+                    std::cerr << "Session expired: " << it->first << std::endl;
+                    it = sessions.erase(it);
+                    continue;
+                }
+                ++it;
+            }
+        }
+        keepalive_timer = loop.add_timer(kKeepaliveInterval, keepalive);
+    };
+    keepalive_timer = loop.add_timer(kKeepaliveInterval, keepalive);
+    
+    // Open streams hold httplib's threads, so they end before it joins them
+    auto close_streams = [&connections, &connections_mutex]() {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (auto& [id, conn] : connections) {
+            std::lock_guard<std::mutex> conn_lock(conn->mutex);
+            conn->active = false;
+            conn->cv.notify_all();
+        }
+    };
+    
+    // list_changed notifications from runtime registrations reach every
+    // initialized stream
+    int broadcast_sink = add_broadcast_sink(broadcast_notification);
+    {
+        std::lock_guard<std::mutex> lock(sse_mutex_);
+        stop_sse_ = [&server, &close_streams] {
+            server.wait_until_ready();
+            server.stop();
+            close_streams();
+        };
+    }
+    if (on_bound) {
+        on_bound(true);
+    }
+    server.listen_after_bind();
+    {
+        std::lock_guard<std::mutex> lock(sse_mutex_);
+        stop_sse_ = nullptr;
+    }
+    remove_broadcast_sink(broadcast_sink);
+    {
+        std::lock_guard<std::mutex> lock(streams_open->mutex);
+        streams_open->open = false;
+    }
+    
+    loop.call([&] {
+        stopped = true;
+        loop.cancel_timer(keepalive_timer);
+    });
+    close_streams();
 }
 
 } // namespace mcp
@@ -0,0 +1,595 @@
+#include <cppmcp/message_encoding.hpp>
+#include <cppmcp/message_limits.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace mcp {
+
+// Media type of one Content-Type/Accept entry: lower case, without
+// parameters or surrounding whitespace
+static std::string media_type(const std::string& entry) {
+    size_t end = entry.find(';');
+    std::string type = entry.substr(0, end);
+    type.erase(0, type.find_first_not_of(" \t"));
+    type.erase(type.find_last_not_of(" \t") + 1);
+    std::transform(type.begin(), type.end(), type.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return type;
+}
+
+static bool parse_media_type(const std::string& type, MessageEncoding& encoding) {
+    if (type == "application/cbor") {
+        encoding = MessageEncoding::CBOR;
+        return true;
+    }
+    if (type == "application/msgpack" || type == "application/x-msgpack" ||
+        type == "application/vnd.msgpack") {
+        encoding = MessageEncoding::MessagePack;
+        return true;
+    }
+    return false;
+}
+
+const char* content_type(MessageEncoding encoding) {
+    switch (encoding) {
+        case MessageEncoding::CBOR: return "application/cbor";
+        case MessageEncoding::MessagePack: return "application/msgpack";
+        default: return "application/json";
+    }
+}
+
+MessageEncoding encoding_from_content_type(const std::string& header) {
+    MessageEncoding encoding = MessageEncoding::JSON;
+    parse_media_type(media_type(header), encoding);
+    return encoding;
+}
+
+// Quality of one Accept entry: its q parameter, 1 when absent
+static double quality(const std::string& entry) {
+    size_t param = entry.find(';');
+    while (param != std::string::npos) {
+        size_t name = entry.find_first_not_of(" \t", param + 1);
+        param = entry.find(';', param + 1);
+        if (name != std::string::npos && name + 1 < entry.size() &&
+            std::tolower(static_cast<unsigned char>(entry[name])) == 'q' && entry[name + 1] == '=') {
+            return std::strtod(entry.c_str() + name + 2, nullptr);
+        }
+    }
+    return 1.0;
+}
+
+MessageEncoding encoding_from_accept(const std::string& header) {
+    // Highest quality wins and the earlier entry breaks ties, so JSON
+    // listed first is kept. Wildcards stand for JSON, the default.
+    MessageEncoding best = MessageEncoding::JSON;
+    double best_quality = 0;
+    size_t begin = 0;
+    while (begin <= header.size()) {
+        size_t end = header.find(',', begin);
+        if (end == std::string::npos) {
+            end = header.size();
+        }
+        std::string entry = header.substr(begin, end - begin);
+        std::string type = media_type(entry);
+        MessageEncoding encoding = MessageEncoding::JSON;
+        if (type == "application/json" || type == "application/*" || type == "*/*" ||
+            parse_media_type(type, encoding)) {
+            double q = quality(entry);
+            if (q > best_quality) {
+                best = encoding;
+                best_quality = q;
+            }
+        }
+        begin = end + 1;
+    }
+    return best;
+}
+
+// Builds the document like json::parse, but stops at the first container
+// nested deeper than the limit. The binary readers recurse per level, so
+// this also bounds their stack use.
+class DepthLimitedBuilder : public nlohmann::detail::json_sax_dom_parser<json> {
+public:
+    using Base = nlohmann::detail::json_sax_dom_parser<json>;
+
+    DepthLimitedBuilder(json& result, size_t max_depth)
+        : Base(result, true), max_depth_(max_depth), depth_(0) {}
+
+    bool start_object(std::size_t size) { return enter() && Base::start_object(size); }
+    bool end_object() { --depth_; return Base::end_object(); }
+    bool start_array(std::size_t size) { return enter() && Base::start_array(size); }
+    bool end_array() { --depth_; return Base::end_array(); }
+
+    bool too_deep() const { return depth_ > max_depth_; }
+
+private:
+    bool enter() { return ++depth_ <= max_depth_; }
+
+    size_t max_depth_;
+    size_t depth_;
+};
+
+json decode_message(const std::string& body, MessageEncoding encoding, size_t max_depth) {
+    if (max_depth == 0) {
+        switch (encoding) {
+            case MessageEncoding::CBOR: return json::from_cbor(body);
+            case MessageEncoding::MessagePack: return json::from_msgpack(body);
+            default: return json::parse(body);
+        }
+    }
+
+    json::input_format_t format = encoding == MessageEncoding::CBOR ? json::input_format_t::cbor
+                                : encoding == MessageEncoding::MessagePack ? json::input_format_t::msgpack
+                                : json::input_format_t::json;
+    json result;
+    DepthLimitedBuilder builder(result, max_depth);
+    if (!json::sax_parse(body, &builder, format) && builder.too_deep()) {
+        throw MessageLimitError::too_deep(max_depth);
+    }
+    return result;
+}
+
+std::string encode_message(const json& message, MessageEncoding encoding) {
+    std::string out;
+    switch (encoding) {
+        case MessageEncoding::CBOR:
+            json::to_cbor(message, out);
+            break;
+        case MessageEncoding::MessagePack:
+            json::to_msgpack(message, out);
+            break;
+        default:
+            out = message.dump();
+            break;
+    }
+    return out;
+}
+
+// Reads JSON text and writes the same message as CBOR or MessagePack,
+// with no document in between. Runs of string text without escapes are
+// copied whole. Container sizes aren't known when they open, so each gets a
+// four-byte count that is filled in when it closes.
+class BinaryTranscoder {
+public:
+    BinaryTranscoder(std::string& out, MessageEncoding encoding)
+        : out_(out), cbor_(encoding == MessageEncoding::CBOR) {}
+
+    // False for text that isn't valid JSON
+    bool transcode(std::string_view text) {
+        text_ = text;
+        pos_ = 0;
+        while (true) {
+            // A value, or the end of an empty container
+            skip_whitespace();
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            char c = text_[pos_];
+            if ((c == ']' && !open_.empty() && !open_.back().object && open_.back().count == 0) ||
+                (c == '}' && !open_.empty() && open_.back().object && open_.back().count == 0)) {
+                ++pos_;
+                if (!close()) {
+                    return false;
+                }
+            } else if (c == '{' || c == '[') {
+                ++pos_;
+                open(c == '{');
+                if (c == '{') {
+                    skip_whitespace();
+                    if (pos_ < text_.size() && text_[pos_] == '}') {
+                        continue;
+                    }
+                    if (!key()) {
+                        return false;
+                    }
+                }
+                continue;
+            } else if (!scalar()) {
+                return false;
+            }
+            
+            // What follows a value: another entry or the containers' ends
+            while (true) {
+                skip_whitespace();
+                if (open_.empty()) {
+                    return pos_ == text_.size();
+                }
+                if (pos_ >= text_.size()) {
+                    return false;
+                }
+                char next = text_[pos_++];
+                if (next == ',') {
+                    if (open_.back().object && !key()) {
+                        return false;
+                    }
+                    break;
+                }
+                if (next != (open_.back().object ? '}' : ']') || !close()) {
+                    return false;
+                }
+            }
+        }
+    }
+
+private:
+    // Containers still open: where their count goes and what it is so far.
+    // Objects count their keys.
+    struct Container {
+        size_t offset;
+        uint64_t count;
+        bool object;
+    };
+
+    void skip_whitespace() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' || text_[pos_] == '\t')) {
+            ++pos_;
+        }
+    }
+
+    // An object member's name and colon
+    bool key() {
+        skip_whitespace();
+        if (pos_ >= text_.size() || text_[pos_] != '"') {
+            return false;
+        }
+        ++open_.back().count;
+        if (!string()) {
+            return false;
+        }
+        skip_whitespace();
+        return pos_ < text_.size() && text_[pos_++] == ':';
+    }
+
+    // A value that isn't a container; counts towards an enclosing array
+    bool scalar() {
+        if (!open_.empty() && !open_.back().object) {
+            ++open_.back().count;
+        }
+        char c = text_[pos_];
+        if (c == '"') {
+            return string();
+        }
+        if (literal("null")) {
+            return byte(cbor_ ? 0xf6 : 0xc0);
+        }
+        if (literal("true")) {
+            return byte(cbor_ ? 0xf5 : 0xc3);
+        }
+        if (literal("false")) {
+            return byte(cbor_ ? 0xf4 : 0xc2);
+        }
+        return number();
+    }
+
+    bool literal(std::string_view word) {
+        if (text_.compare(pos_, word.size(), word) != 0) {
+            return false;
+        }
+        pos_ += word.size();
+        return true;
+    }
+
+    bool number() {
+        size_t begin = pos_;
+        if (pos_ < text_.size() && text_[pos_] == '-') {
+            ++pos_;
+        }
+        size_t digits = pos_;
+        while (pos_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+        if (pos_ == digits || (text_[digits] == '0' && pos_ - digits > 1)) {
+            return false;
+        }
+        bool integral = true;
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            integral = false;
+            size_t fraction = ++pos_;
+            while (pos_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[pos_]))) {
+                ++pos_;
+            }
+            if (pos_ == fraction) {
+                return false;
+            }
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            integral = false;
+            ++pos_;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+                ++pos_;
+            }
+            size_t exponent = pos_;
+            while (pos_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[pos_]))) {
+                ++pos_;
+            }
+            if (pos_ == exponent) {
+                return false;
+            }
+        }
+        
+        // Integers that don't fit 64 bits become doubles, as with json::parse
+        std::string token(text_.substr(begin, pos_ - begin));
+        errno = 0;
+        if (integral && text_[begin] == '-') {
+            long long value = std::strtoll(token.c_str(), nullptr, 10);
+            if (errno == 0) {
+                negative(value);
+                return true;
+            }
+        } else if (integral) {
+            unsigned long long value = std::strtoull(token.c_str(), nullptr, 10);
+            if (errno == 0) {
+                unsigned_number(value);
+                return true;
+            }
+        }
+        double value = std::strtod(token.c_str(), nullptr);
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        byte(cbor_ ? 0xfb : 0xcb);
+        big_endian(bits, 8);
+        return true;
+    }
+
+    // Strings without escapes are copied straight from the text
+    bool string() {
+        size_t begin = ++pos_;
+        size_t end = text_.find('"', begin);
+        if (end == std::string_view::npos) {
+            return false;
+        }
+        std::string_view raw = text_.substr(begin, end - begin);
+        if (raw.find('\\') == std::string_view::npos) {
+            for (char c : raw) {
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    return false;
+                }
+            }
+            string_head(raw.size());
+            out_.append(raw.data(), raw.size());
+            pos_ = end + 1;
+            return true;
+        }
+        
+        // Otherwise unescape into scratch, copying the runs between escapes
+        scratch_.clear();
+        size_t escape = begin + raw.find('\\');
+        size_t quote = end;
+        while (true) {
+            if (quote < pos_) {
+                quote = text_.find('"', pos_);
+                if (quote == std::string_view::npos) {
+                    return false;
+                }
+            }
+            if (escape < pos_) {
+                escape = text_.find('\\', pos_);
+            }
+            size_t run_end = std::min(quote, escape);
+            for (size_t i = pos_; i < run_end; ++i) {
+                if (static_cast<unsigned char>(text_[i]) < 0x20) {
+                    return false;
+                }
+            }
+            scratch_.append(text_.data() + pos_, run_end - pos_);
+            pos_ = run_end + 1;
+            if (run_end == quote) {
+                break;
+            }
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            switch (text_[pos_++]) {
+                case '"': scratch_ += '"'; break;
+                case '\\': scratch_ += '\\'; break;
+                case '/': scratch_ += '/'; break;
+                case 'b': scratch_ += '\b'; break;
+                case 'f': scratch_ += '\f'; break;
+                case 'n': scratch_ += '\n'; break;
+                case 'r': scratch_ += '\r'; break;
+                case 't': scratch_ += '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (!hex4(code)) {
+                        return false;
+                    }
+                    if (code >= 0xd800 && code <= 0xdbff) {
+                        uint32_t low;
+                        if (!literal("\\u") || !hex4(low) || low < 0xdc00 || low > 0xdfff) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    } else if (code >= 0xdc00 && code <= 0xdfff) {
+                        return false;
+                    }
+                    utf8(code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        string_head(scratch_.size());
+        out_ += scratch_;
+        return true;
+    }
+
+    bool hex4(uint32_t& code) {
+        if (pos_ + 4 > text_.size()) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text_[pos_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void utf8(uint32_t code) {
+        if (code < 0x80) {
+            scratch_ += static_cast<char>(code);
+        } else if (code < 0x800) {
+            scratch_ += static_cast<char>(0xc0 | (code >> 6));
+            scratch_ += static_cast<char>(0x80 | (code & 0x3f));
+        } else if (code < 0x10000) {
+            scratch_ += static_cast<char>(0xe0 | (code >> 12));
+            scratch_ += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            scratch_ += static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+            scratch_ += static_cast<char>(0xf0 | (code >> 18));
+            scratch_ += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            scratch_ += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            scratch_ += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    bool byte(uint8_t b) {
+        out_ += static_cast<char>(b);
+        return true;
+    }
+
+    void big_endian(uint64_t number, int bytes) {
+        for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+            out_ += static_cast<char>((number >> shift) & 0xff);
+        }
+    }
+
+    // CBOR head: major type and argument in the shortest form
+    void head(uint8_t major, uint64_t argument) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (argument < 24) {
+            byte(static_cast<uint8_t>(type | argument));
+        } else if (argument <= 0xff) {
+            byte(type | 24);
+            big_endian(argument, 1);
+        } else if (argument <= 0xffff) {
+            byte(type | 25);
+            big_endian(argument, 2);
+        } else if (argument <= 0xffffffff) {
+            byte(type | 26);
+            big_endian(argument, 4);
+        } else {
+            byte(type | 27);
+            big_endian(argument, 8);
+        }
+    }
+
+    void unsigned_number(uint64_t number) {
+        if (cbor_) {
+            head(0, number);
+        } else if (number <= 0x7f) {
+            byte(static_cast<uint8_t>(number));
+        } else if (number <= 0xff) {
+            byte(0xcc);
+            big_endian(number, 1);
+        } else if (number <= 0xffff) {
+            byte(0xcd);
+            big_endian(number, 2);
+        } else if (number <= 0xffffffff) {
+            byte(0xce);
+            big_endian(number, 4);
+        } else {
+            byte(0xcf);
+            big_endian(number, 8);
+        }
+    }
+
+    void negative(int64_t number) {
+        if (number >= 0) {
+            unsigned_number(static_cast<uint64_t>(number));
+        } else if (cbor_) {
+            head(1, static_cast<uint64_t>(-(number + 1)));
+        } else if (number >= -32) {
+            byte(static_cast<uint8_t>(number));
+        } else if (number >= INT8_MIN) {
+            byte(0xd0);
+            big_endian(static_cast<uint64_t>(number), 1);
+        } else if (number >= INT16_MIN) {
+            byte(0xd1);
+            big_endian(static_cast<uint64_t>(number), 2);
+        } else if (number >= INT32_MIN) {
+            byte(0xd2);
+            big_endian(static_cast<uint64_t>(number), 4);
+        } else {
+            byte(0xd3);
+            big_endian(static_cast<uint64_t>(number), 8);
+        }
+    }
+
+    void string_head(size_t size) {
+        if (cbor_) {
+            head(3, size);
+        } else if (size <= 31) {
+            byte(static_cast<uint8_t>(0xa0 | size));
+        } else if (size <= 0xff) {
+            byte(0xd9);
+            big_endian(size, 1);
+        } else if (size <= 0xffff) {
+            byte(0xda);
+            big_endian(size, 2);
+        } else {
+            byte(0xdb);
+            big_endian(size, 4);
+        }
+    }
+
+    void open(bool object) {
+        if (!open_.empty() && !open_.back().object) {
+            ++open_.back().count;
+        }
+        byte(object ? (cbor_ ? 0xba : 0xdf) : (cbor_ ? 0x9a : 0xdd));
+        open_.push_back(Container{out_.size(), 0, object});
+        out_.append(4, '\0');
+    }
+
+    bool close() {
+        Container container = open_.back();
+        open_.pop_back();
+        if (container.count > 0xffffffff) {
+            return false;
+        }
+        for (int i = 0; i < 4; ++i) {
+            out_[container.offset + i] = static_cast<char>((container.count >> ((3 - i) * 8)) & 0xff);
+        }
+        return true;
+    }
+
+    std::string& out_;
+    bool cbor_;
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::vector<Container> open_;
+    std::string scratch_;  // Unescaped text of a string with escapes
+};
+
+std::string encode_message_text(const std::string& text, MessageEncoding encoding) {
+    if (encoding == MessageEncoding::JSON) {
+        return text;
+    }
+    std::string out;
+    out.reserve(text.size());
+    BinaryTranscoder transcoder(out, encoding);
+    if (!transcoder.transcode(text)) {
+        // Reports the parse error as json::parse would
+        return encode_message(json::parse(text), encoding);
+    }
+    return out;
+}
+
+} // namespace mcp
@@ -0,0 +1,64 @@
+#include <cppmcp/message_limits.hpp>
+
+namespace mcp {
+
+MessageLimiter::MessageLimiter(size_t max_bytes, size_t max_depth)
+    : max_bytes_(max_bytes), max_depth_(max_depth), bytes_(0), depth_(0),
+      in_string_(false), escaped_(false), exceeded_(false) {}
+
+bool MessageLimiter::feed_bytes(size_t size) {
+    bytes_ += size;
+    if (max_bytes_ != 0 && bytes_ > max_bytes_) {
+        exceeded_ = true;
+    }
+    return !exceeded_;
+}
+
+bool MessageLimiter::feed(const char* data, size_t size) {
+    if (!feed_bytes(size)) {
+        return false;
+    }
+    if (max_depth_ == 0) {
+        return true;
+    }
+
+    for (const char* p = data, *end = data + size; p != end; ++p) {
+        char c = *p;
+        if (in_string_) {
+            if (escaped_) {
+                escaped_ = false;
+            } else if (c == '\\') {
+                escaped_ = true;
+            } else if (c == '"') {
+                in_string_ = false;
+            }
+            continue;
+        }
+        switch (c) {
+            case '"':
+                in_string_ = true;
+                break;
+            case '{':
+            case '[':
+                if (++depth_ > max_depth_) {
+                    return false;
+                }
+                break;
+            case '}':
+            case ']':
+                if (depth_ > 0) {
+                    --depth_;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+MessageLimitError MessageLimiter::error() const {
+    return exceeded_ ? MessageLimitError::too_large(max_bytes_) : MessageLimitError::too_deep(max_depth_);
+}
+
+} // namespace mcp
@@ -0,0 +1,82 @@
+#include <cppmcp/request_context.hpp>
+
+namespace mcp {
+
+static thread_local RequestContext* current_context = nullptr;
+
+void CancellationToken::set_deadline(Clock::time_point deadline) {
+    Clock::rep ticks = deadline.time_since_epoch().count();
+    Clock::rep current = deadline_.load(std::memory_order_acquire);
+    while (ticks < current &&
+           !deadline_.compare_exchange_weak(current, ticks, std::memory_order_acq_rel)) {
+    }
+}
+
+CancellationToken::Clock::time_point CancellationToken::deadline() const {
+    return Clock::time_point(Clock::duration(deadline_.load(std::memory_order_acquire)));
+}
+
+CancellationToken::Clock::duration CancellationToken::remaining() const {
+    if (!has_deadline()) {
+        return Clock::duration::max();
+    }
+    return deadline() - Clock::now();
+}
+
+CancellationToken::Clock::duration RequestContext::remaining() const {
+    return token_ ? token_->remaining() : CancellationToken::Clock::duration::max();
+}
+
+RequestContext::RequestContext(json id, std::shared_ptr<CancellationToken> token,
+                               json progress_token, NotificationSink notify)
+    : id_(std::move(id)), token_(std::move(token)),
+      progress_token_(std::move(progress_token)), notify_(std::move(notify)) {
+}
+
+bool RequestContext::report_progress(double progress, double total, const std::string& message) {
+    if (progress_token_.is_null()) {
+        return false;
+    }
+    
+    json params = {
+        {"progressToken", progress_token_},
+        {"progress", progress}
+    };
+    if (total > 0) {
+        params["total"] = total;
+    }
+    if (!message.empty()) {
+        params["message"] = message;
+    }
+    
+    return notify("notifications/progress", params);
+}
+
+bool RequestContext::notify(const std::string& method, const json& params) {
+    if (!notify_) {
+        return false;
+    }
+    
+    json notification = {
+        {"jsonrpc", "2.0"},
+        {"method", method},
+        {"params", params}
+    };
+    notify_(notification.dump());
+    return true;
+}
+
+RequestContext* RequestContext::current() {
+    return current_context;
+}
+
+RequestContext::Scope::Scope(RequestContext* context)
+    : previous_(current_context) {
+    current_context = context;
+}
+
+RequestContext::Scope::~Scope() {
+    current_context = previous_;
+}
+
+} // namespace mcp
@@ -0,0 +1,327 @@
+#include <cppmcp/schema_validator.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mcp {
+
+static uint8_t parse_type(const std::string& name) {
+    if (name == "null") return 1 << 0;
+    if (name == "boolean") return 1 << 1;
+    if (name == "integer") return 1 << 2;
+    if (name == "number") return 1 << 3;
+    if (name == "string") return 1 << 4;
+    if (name == "array") return 1 << 5;
+    if (name == "object") return 1 << 6;
+    throw std::invalid_argument("Unknown schema type: " + name);
+}
+
+static const char* type_name(const json& value) {
+    switch (value.type()) {
+        case json::value_t::null: return "null";
+        case json::value_t::boolean: return "boolean";
+        case json::value_t::number_integer:
+        case json::value_t::number_unsigned: return "integer";
+        case json::value_t::number_float: return "number";
+        case json::value_t::string: return "string";
+        case json::value_t::array: return "array";
+        case json::value_t::object: return "object";
+        default: return "binary";
+    }
+}
+
+// "number or string" for a type mask; integer is implied by number
+static std::string type_names(uint8_t types) {
+    static const char* const kNames[] = {"null", "boolean", "integer", "number", "string", "array", "object"};
+    std::string names;
+    for (int bit = 0; bit < 7; ++bit) {
+        if ((types & (1 << bit)) && !(bit == 2 && (types & (1 << 3)))) {
+            names += names.empty() ? "" : " or ";
+            names += kNames[bit];
+        }
+    }
+    return names;
+}
+
+static size_t size_value(const json& schema, const char* key) {
+    const json& value = schema[key];
+    if (!value.is_number_unsigned() && !(value.is_number_integer() && value.get<int64_t>() >= 0)) {
+        throw std::invalid_argument(std::string("Schema '") + key + "' must be a non-negative integer");
+    }
+    return value.get<size_t>();
+}
+
+static double number_value(const json& schema, const char* key) {
+    const json& value = schema[key];
+    if (!value.is_number()) {
+        throw std::invalid_argument(std::string("Schema '") + key + "' must be a number");
+    }
+    return value.get<double>();
+}
+
+// Bounds as written in the schema: 4096 rather than 4096.0
+static std::string format_number(double number) {
+    if (std::floor(number) == number && std::fabs(number) < 1e15) {
+        return std::to_string(static_cast<int64_t>(number));
+    }
+    return json(number).dump();
+}
+
+// Code points in UTF-8 text, as JSON Schema measures string length
+static size_t utf8_length(const std::string& text) {
+    size_t length = 0;
+    for (unsigned char c : text) {
+        length += (c & 0xC0) != 0x80;
+    }
+    return length;
+}
+
+SchemaValidator::SchemaValidator(const json& schema) {
+    compile(schema);
+}
+
+bool SchemaValidator::has_constraints() const {
+    const Node& root = nodes_.front();
+    return nodes_.size() > 1 || root.types != kAnyType || !root.properties.empty() ||
+           !root.additional_allowed || root.has_allowed || root.has_minimum || root.has_maximum ||
+           root.min_length != 0 || root.max_length != SIZE_MAX ||
+           root.min_items != 0 || root.max_items != SIZE_MAX;
+}
+
+int SchemaValidator::compile(const json& schema) {
+    int index = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+    if (schema.is_null() || schema.is_boolean()) {
+        return index;
+    }
+    if (!schema.is_object()) {
+        throw std::invalid_argument("Schema must be an object");
+    }
+
+    // Children are compiled before the node is filled in, since they may
+    // grow nodes_; the node is written back at the end
+    Node node;
+
+    if (schema.contains("type")) {
+        const json& type = schema["type"];
+        if (type.is_string()) {
+            node.types = parse_type(type.get<std::string>());
+        } else if (type.is_array()) {
+            node.types = 0;
+            for (const auto& name : type) {
+                if (!name.is_string()) {
+                    throw std::invalid_argument("Schema 'type' entries must be strings");
+                }
+                node.types |= parse_type(name.get<std::string>());
+            }
+        } else {
+            throw std::invalid_argument("Schema 'type' must be a string or array");
+        }
+        // Integers are numbers
+        if (node.types & kNumber) {
+            node.types |= kInteger;
+        }
+    }
+
+    if (schema.contains("enum")) {
+        if (!schema["enum"].is_array()) {
+            throw std::invalid_argument("Schema 'enum' must be an array");
+        }
+        node.allowed = schema["enum"].get<std::vector<json>>();
+        node.has_allowed = true;
+    }
+    if (schema.contains("const")) {
+        node.allowed = {schema["const"]};
+        node.has_allowed = true;
+    }
+
+    if (schema.contains("properties")) {
+        if (!schema["properties"].is_object()) {
+            throw std::invalid_argument("Schema 'properties' must be an object");
+        }
+        for (const auto& [name, property] : schema["properties"].items()) {
+            node.properties.push_back({name, compile(property), false});
+        }
+    }
+    if (schema.contains("required")) {
+        if (!schema["required"].is_array()) {
+            throw std::invalid_argument("Schema 'required' must be an array");
+        }
+        for (const auto& name : schema["required"]) {
+            if (!name.is_string()) {
+                throw std::invalid_argument("Schema 'required' entries must be strings");
+            }
+            auto it = std::find_if(node.properties.begin(), node.properties.end(),
+                                   [&](const Property& p) { return p.name == name; });
+            if (it != node.properties.end()) {
+                it->required = true;
+            } else {
+                node.properties.push_back({name.get<std::string>(), -1, true});
+            }
+        }
+    }
+    if (schema.contains("additionalProperties")) {
+        const json& additional = schema["additionalProperties"];
+        if (additional.is_boolean()) {
+            node.additional_allowed = additional.get<bool>();
+        } else {
+            node.additional = compile(additional);
+        }
+    }
+
+    if (schema.contains("items") && schema["items"].is_object()) {
+        node.items = compile(schema["items"]);
+    }
+
+    if (schema.contains("minimum")) {
+        node.minimum = number_value(schema, "minimum");
+        node.has_minimum = true;
+    }
+    if (schema.contains("maximum")) {
+        node.maximum = number_value(schema, "maximum");
+        node.has_maximum = true;
+    }
+    // Numbers since draft 6; booleans modifying minimum/maximum before
+    if (schema.contains("exclusiveMinimum")) {
+        if (schema["exclusiveMinimum"].is_boolean()) {
+            node.exclusive_minimum = schema["exclusiveMinimum"].get<bool>();
+        } else {
+            node.minimum = number_value(schema, "exclusiveMinimum");
+            node.has_minimum = node.exclusive_minimum = true;
+        }
+    }
+    if (schema.contains("exclusiveMaximum")) {
+        if (schema["exclusiveMaximum"].is_boolean()) {
+            node.exclusive_maximum = schema["exclusiveMaximum"].get<bool>();
+        } else {
+            node.maximum = number_value(schema, "exclusiveMaximum");
+            node.has_maximum = node.exclusive_maximum = true;
+        }
+    }
+    if (schema.contains("minLength")) node.min_length = size_value(schema, "minLength");
+    if (schema.contains("maxLength")) node.max_length = size_value(schema, "maxLength");
+    if (schema.contains("minItems")) node.min_items = size_value(schema, "minItems");
+    if (schema.contains("maxItems")) node.max_items = size_value(schema, "maxItems");
+
+    nodes_[index] = std::move(node);
+    return index;
+}
+
+bool SchemaValidator::validate(const json& value, std::string& error) const {
+    std::string path;
+    return check(0, value, path, error);
+}
+
+bool SchemaValidator::check(int index, const json& value, std::string& path, std::string& error) const {
+    const Node& node = nodes_[index];
+    auto fail = [&](const std::string& message) {
+        error = (path.empty() ? std::string("arguments") : path) + ": " + message;
+        return false;
+    };
+
+    uint8_t type;
+    switch (value.type()) {
+        case json::value_t::null: type = kNull; break;
+        case json::value_t::boolean: type = kBoolean; break;
+        case json::value_t::number_integer:
+        case json::value_t::number_unsigned: type = kInteger; break;
+        case json::value_t::number_float: {
+            double number = value.get<double>();
+            type = std::isfinite(number) && std::floor(number) == number ? (kNumber | kInteger) : kNumber;
+            break;
+        }
+        case json::value_t::string: type = kString; break;
+        case json::value_t::array: type = kArray; break;
+        case json::value_t::object: type = kObject; break;
+        default: type = 0; break;
+    }
+    if ((node.types & type) == 0) {
+        return fail("expected " + type_names(node.types) + ", got " + type_name(value));
+    }
+
+    if (node.has_allowed &&
+        std::find(node.allowed.begin(), node.allowed.end(), value) == node.allowed.end()) {
+        return fail("value is not one of the allowed values");
+    }
+
+    if (value.is_number()) {
+        double number = value.get<double>();
+        if (node.has_minimum && (node.exclusive_minimum ? number <= node.minimum : number < node.minimum)) {
+            return fail("must be " + std::string(node.exclusive_minimum ? "greater than " : "at least ") +
+                        format_number(node.minimum));
+        }
+        if (node.has_maximum && (node.exclusive_maximum ? number >= node.maximum : number > node.maximum)) {
+            return fail("must be " + std::string(node.exclusive_maximum ? "less than " : "at most ") +
+                        format_number(node.maximum));
+        }
+    } else if (value.is_string()) {
+        if (node.min_length != 0 || node.max_length != SIZE_MAX) {
+            size_t length = utf8_length(value.get_ref<const std::string&>());
+            if (length < node.min_length) {
+                return fail("must be at least " + std::to_string(node.min_length) + " characters");
+            }
+            if (length > node.max_length) {
+                return fail("must be at most " + std::to_string(node.max_length) + " characters");
+            }
+        }
+    } else if (value.is_array()) {
+        if (value.size() < node.min_items) {
+            return fail("must have at least " + std::to_string(node.min_items) + " items");
+        }
+        if (value.size() > node.max_items) {
+            return fail("must have at most " + std::to_string(node.max_items) + " items");
+        }
+        if (node.items >= 0) {
+            size_t length = path.size();
+            for (size_t i = 0; i < value.size(); ++i) {
+                path += '[' + std::to_string(i) + ']';
+                if (!check(node.items, value[i], path, error)) {
+                    return false;
+                }
+                path.resize(length);
+            }
+        }
+    } else if (value.is_object()) {
+        size_t length = path.size();
+        size_t matched = 0;
+        for (const Property& property : node.properties) {
+            auto it = value.find(property.name);
+            if (it == value.end()) {
+                if (property.required) {
+                    return fail("missing required property '" + property.name + "'");
+                }
+                continue;
+            }
+            if (property.node >= 0) {
+                ++matched;
+                path += path.empty() ? property.name : "." + property.name;
+                if (!check(property.node, *it, path, error)) {
+                    return false;
+                }
+                path.resize(length);
+            }
+        }
+
+        // Only walk the object again when it has undeclared properties
+        if ((!node.additional_allowed || node.additional >= 0) && matched != value.size()) {
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                bool declared = std::any_of(node.properties.begin(), node.properties.end(),
+                    [&](const Property& p) { return p.node >= 0 && p.name == it.key(); });
+                if (declared) {
+                    continue;
+                }
+                if (!node.additional_allowed) {
+                    return fail("unexpected property '" + it.key() + "'");
+                }
+                path += path.empty() ? it.key() : "." + it.key();
+                if (!check(node.additional, it.value(), path, error)) {
+                    return false;
+                }
+                path.resize(length);
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace mcp
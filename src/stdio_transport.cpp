@@ -0,0 +1,495 @@
+#include <cppmcp/stdio_transport.hpp>
+#include <cppmcp/event_loop.hpp>
+#include <cppmcp/message_limits.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <strings.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mcp {
+
+// Messages held while corked before they are written anyway, so a long
+// run of buffered input doesn't delay every response until it is drained
+static const size_t kMaxCorkedMessages = 64;
+
+// Largest header block accepted before a Content-Length body
+static const size_t kMaxHeaderBytes = 8 * 1024;
+
+std::string content_length_header(size_t length) {
+    return "Content-Length: " + std::to_string(length) + "\r\n\r\n";
+}
+
+// Parse the header block at the start of data. Returns 1 when it is
+// complete and valid, with its size (through the blank line) and the body
+// length; 0 when it continues past the data; -1 when it is malformed, with
+// header_size spanning it so it can be skipped.
+static int parse_headers(const char* data, size_t size, size_t& header_size, size_t& length) {
+    bool has_length = false;
+    bool valid = true;
+    size_t pos = 0;
+    while (true) {
+        const char* newline = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+        if (!newline) {
+            return 0;
+        }
+        size_t start = pos;
+        size_t stop = static_cast<size_t>(newline - data);
+        pos = stop + 1;
+        if (stop > start && data[stop - 1] == '\r') {
+            --stop;
+        }
+        
+        if (stop == start) {
+            header_size = pos;
+            return valid && has_length ? 1 : -1;
+        }
+        
+        const char* colon = static_cast<const char*>(std::memchr(data + start, ':', stop - start));
+        if (!colon) {
+            valid = false;
+            continue;
+        }
+        static const char kName[] = "Content-Length";
+        if (static_cast<size_t>(colon - (data + start)) != sizeof(kName) - 1 ||
+            strncasecmp(data + start, kName, sizeof(kName) - 1) != 0) {
+            continue;  // Content-Type and any others are ignored
+        }
+        
+        size_t value = 0;
+        size_t digits = 0;
+        const char* p = colon + 1;
+        const char* end = data + stop;
+        while (p != end && (*p == ' ' || *p == '\t')) ++p;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p, ++digits) {
+            if (value > (SIZE_MAX - 9) / 10) {
+                valid = false;
+                break;
+            }
+            value = value * 10 + static_cast<size_t>(*p - '0');
+        }
+        while (p != end && (*p == ' ' || *p == '\t')) ++p;
+        if (digits == 0 || p != end) {
+            valid = false;
+        }
+        length = value;
+        has_length = true;
+    }
+}
+
+FrameReader::FrameReader(int fd, StdioFraming framing, size_t buffer_size)
+    : fd_(fd), framing_(framing), buffer_(buffer_size), begin_(0), end_(0), eof_(false) {}
+
+bool FrameReader::fill() {
+    // Move what's left to the front so the whole buffer is free, growing
+    // it if what's left already fills it (a long header block)
+    if (begin_ != 0) {
+        std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (end_ == buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+    }
+
+    while (true) {
+        ssize_t count = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+        if (count > 0) {
+            end_ += static_cast<size_t>(count);
+            return true;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        eof_ = true;  // End of input, or an error that ends it
+        return false;
+    }
+}
+
+bool FrameReader::has_buffered_message() const {
+    const char* data = buffer_.data() + begin_;
+    size_t size = end_ - begin_;
+    if (framing_ != StdioFraming::ContentLength) {
+        return std::memchr(data, '\n', size) != nullptr;
+    }
+    
+    while (size > 0 && (*data == '\r' || *data == '\n')) {
+        ++data;
+        --size;
+    }
+    size_t header_size = 0;
+    size_t length = 0;
+    int parsed = parse_headers(data, size, header_size, length);
+    return parsed < 0 || (parsed > 0 && size - header_size >= length);
+}
+
+bool FrameReader::read(std::string& message, MessageLimiter& limiter) {
+    message.clear();
+    if (framing_ == StdioFraming::Auto) {
+        detect_framing();
+    }
+    if (framing_ == StdioFraming::ContentLength) {
+        return read_content(message, limiter);
+    }
+    return read_line(message, limiter);
+}
+
+// A Content-Length stream starts with a header ("Content-Length" or
+// "Content-Type"); a JSON text never does
+void FrameReader::detect_framing() {
+    static const char kPrefix[] = "content-";
+    const size_t prefix_size = sizeof(kPrefix) - 1;
+    while (true) {
+        size_t compare = std::min(end_ - begin_, prefix_size);
+        if (strncasecmp(buffer_.data() + begin_, kPrefix, compare) != 0) {
+            framing_ = StdioFraming::Newline;
+            return;
+        }
+        if (compare == prefix_size) {
+            framing_ = StdioFraming::ContentLength;
+            return;
+        }
+        if (eof_ || !fill()) {
+            framing_ = StdioFraming::Newline;
+            return;
+        }
+    }
+}
+
+bool FrameReader::read_line(std::string& line, MessageLimiter& limiter) {
+    bool rejected = false;
+    bool any = false;
+
+    while (true) {
+        if (begin_ == end_) {
+            begin_ = end_ = 0;
+            if (eof_ || !fill()) {
+                break;
+            }
+        }
+        any = true;
+
+        // Take input up to the newline, or all of it if the line continues
+        const char* start = buffer_.data() + begin_;
+        size_t available = end_ - begin_;
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', available));
+        size_t count = newline ? static_cast<size_t>(newline - start) : available;
+
+        if (!rejected && !limiter.feed(start, count)) {
+            rejected = true;
+            std::string().swap(line);
+        }
+        if (!rejected) {
+            line.append(start, count);
+        }
+
+        if (newline) {
+            begin_ += count + 1;
+            break;
+        }
+        begin_ = end_;
+    }
+
+    if (rejected) {
+        throw limiter.error();
+    }
+    return any;
+}
+
+bool FrameReader::read_content(std::string& message, MessageLimiter& limiter) {
+    size_t header_size = 0;
+    size_t length = 0;
+    while (true) {
+        // Blank lines between messages are tolerated
+        while (begin_ != end_ && (buffer_[begin_] == '\r' || buffer_[begin_] == '\n')) {
+            ++begin_;
+        }
+        int parsed = parse_headers(buffer_.data() + begin_, end_ - begin_, header_size, length);
+        if (parsed < 0) {
+            begin_ += header_size;
+            throw std::runtime_error("Invalid Content-Length header");
+        }
+        if (parsed > 0) {
+            break;
+        }
+        if (end_ - begin_ > kMaxHeaderBytes) {
+            begin_ = end_;
+            throw std::runtime_error("Content-Length header exceeds " + std::to_string(kMaxHeaderBytes) + " bytes");
+        }
+        if (eof_ || !fill()) {
+            return false;
+        }
+    }
+    begin_ += header_size;
+    
+    // The size is known up front: an oversized body is skipped unread
+    MessageLimiter size_check = limiter;
+    if (!size_check.feed_bytes(length)) {
+        read_body(nullptr, length);
+        throw size_check.error();
+    }
+    
+    message.resize(length);
+    if (!read_body(&message[0], length)) {
+        message.clear();
+        return false;  // Input ended partway through the body
+    }
+    if (!limiter.feed(message.data(), message.size())) {
+        std::string().swap(message);
+        throw limiter.error();
+    }
+    return true;
+}
+
+// Copy the next size bytes of input to data, or discard them if data is
+// null. What's buffered is copied; a remainder at least a buffer long is
+// read straight into data instead of through the buffer.
+bool FrameReader::read_body(char* data, size_t size) {
+    while (size > 0) {
+        if (begin_ == end_) {
+            begin_ = end_ = 0;
+            if (eof_) {
+                return false;
+            }
+            if (data && size >= buffer_.size()) {
+                ssize_t count = ::read(fd_, data, size);
+                if (count > 0) {
+                    data += count;
+                    size -= static_cast<size_t>(count);
+                    continue;
+                }
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                eof_ = true;
+                return false;
+            }
+            if (!fill()) {
+                return false;
+            }
+        }
+        
+        size_t count = std::min(size, end_ - begin_);
+        if (data) {
+            std::memcpy(data, buffer_.data() + begin_, count);
+            data += count;
+        }
+        begin_ += count;
+        size -= count;
+    }
+    return true;
+}
+
+StdioTransport::StdioTransport(EventLoop& loop, int in_fd, int out_fd, StdioFraming framing,
+                               size_t max_queued_bytes, size_t buffer_size)
+    : loop_(loop), reader_(in_fd, framing, buffer_size), out_fd_(out_fd), saved_out_flags_(-1),
+      head_(new Node), queued_messages_(0), queued_bytes_(0), max_queued_bytes_(max_queued_bytes),
+      corked_(false), stopping_(false), flush_scheduled_(false), batch_stub_(nullptr), next_iov_(0),
+      out_watched_(false), failed_(false), closing_(false), reader_waiting_(false), closed_(false) {
+    tail_ = head_.load();
+    
+    // Only pipes and sockets can be waited on; files and terminals are
+    // written with blocking writes
+    struct stat info;
+    if (fstat(out_fd_, &info) == 0 && (S_ISFIFO(info.st_mode) || S_ISSOCK(info.st_mode))) {
+        int flags = fcntl(out_fd_, F_GETFL);
+        if (flags >= 0 && !(flags & O_NONBLOCK) && fcntl(out_fd_, F_SETFL, flags | O_NONBLOCK) == 0) {
+            saved_out_flags_ = flags;
+        }
+    }
+}
+
+StdioTransport::~StdioTransport() {
+    // Flushes posted earlier run first; only this one may signal closed_
+    stopping_ = true;
+    loop_.post([this] {
+        closing_ = true;
+        flush(false);
+    });
+    {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        drained_cv_.wait(lock, [this] { return closed_; });
+    }
+    if (saved_out_flags_ >= 0) {
+        fcntl(out_fd_, F_SETFL, saved_out_flags_);
+    }
+    delete tail_;
+}
+
+void StdioTransport::write(std::string message) {
+    Node* node = new Node;
+    if (reader_.framing() == StdioFraming::ContentLength) {
+        node->header = content_length_header(message.size());
+    } else {
+        message += '\n';
+    }
+    size_t size = node->header.size() + message.size();
+    node->message = std::move(message);
+    
+    // Counted before the node is linked, so the loop never takes more
+    // than the counters hold
+    queued_messages_ += 1;
+    queued_bytes_ += size;
+    Node* previous = head_.exchange(node);
+    previous->next.store(node);
+    
+    // While corked nothing is written until uncork or a bound
+    if (ready_to_write()) {
+        schedule_flush();
+    }
+}
+
+void StdioTransport::wait_for_capacity() {
+    if (max_queued_bytes_ == 0 || queued_bytes_ < max_queued_bytes_) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    reader_waiting_ = true;
+    capacity_cv_.wait(lock, [this] { return queued_bytes_ < max_queued_bytes_; });
+    reader_waiting_ = false;
+}
+
+void StdioTransport::cork() {
+    corked_ = true;
+}
+
+void StdioTransport::uncork() {
+    corked_ = false;
+    if (queued_messages_ > 0) {
+        schedule_flush();
+    }
+}
+
+void StdioTransport::schedule_flush() {
+    // One flush pending at a time; it takes everything queued by then
+    if (!flush_scheduled_.exchange(true)) {
+        loop_.post([this] { flush(false); });
+    }
+}
+
+bool StdioTransport::ready_to_write() const {
+    size_t messages = queued_messages_;
+    return messages > 0 &&
+           (!corked_ || messages >= kMaxCorkedMessages ||
+            (max_queued_bytes_ != 0 && queued_bytes_ >= max_queued_bytes_));
+}
+
+void StdioTransport::flush(bool writable) {
+    flush_scheduled_ = false;
+    if (out_watched_ && !writable) {
+        return;  // Resumes once the descriptor is writable
+    }
+    
+    while (true) {
+        if (batch_.empty()) {
+            if (!stopping_ && !ready_to_write()) {
+                break;
+            }
+            take_batch();
+            if (batch_.empty()) {
+                break;  // A producer is between counting and linking
+            }
+        }
+        if (!failed_ && !write_batch()) {
+            if (!out_watched_) {
+                out_watched_ = loop_.watch(out_fd_, EPOLLOUT, [this](uint32_t) { flush(true); });
+            }
+            if (out_watched_) {
+                return;
+            }
+            failed_ = true;
+        }
+        release_batch();
+    }
+    
+    if (out_watched_) {
+        loop_.unwatch(out_fd_);
+        out_watched_ = false;
+    }
+    if (closing_ && queued_messages_ == 0) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        closed_ = true;
+        drained_cv_.notify_all();
+    }
+}
+
+void StdioTransport::take_batch() {
+    // Take everything linked so far. The last node taken becomes the new
+    // stub once its message is written.
+    batch_stub_ = tail_;
+    for (Node* next; (next = tail_->next.load()) != nullptr;) {
+        batch_.push_back(next);
+        tail_ = next;
+    }
+    
+    iov_.clear();
+    next_iov_ = 0;
+    for (Node* node : batch_) {
+        if (!node->header.empty()) {
+            iov_.push_back({&node->header[0], node->header.size()});
+        }
+        iov_.push_back({&node->message[0], node->message.size()});
+    }
+}
+
+// True once the batch is written, or output has failed; false if the
+// descriptor is full
+bool StdioTransport::write_batch() {
+    // As few writev calls as possible, resuming after partial writes
+    while (next_iov_ < iov_.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov_.size() - next_iov_, IOV_MAX));
+        ssize_t written = ::writev(out_fd_, &iov_[next_iov_], count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false;
+            }
+            failed_ = true;  // Output closed; drop what's left
+            return true;
+        }
+        
+        size_t remaining = static_cast<size_t>(written);
+        while (next_iov_ < iov_.size() && remaining >= iov_[next_iov_].iov_len) {
+            remaining -= iov_[next_iov_].iov_len;
+            ++next_iov_;
+        }
+        if (remaining > 0) {
+            iov_[next_iov_].iov_base = static_cast<char*>(iov_[next_iov_].iov_base) + remaining;
+            iov_[next_iov_].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+void StdioTransport::release_batch() {
+    size_t bytes = 0;
+    for (Node* node : batch_) {
+        bytes += node->header.size() + node->message.size();
+    }
+    delete batch_stub_;
+    for (size_t i = 0; i + 1 < batch_.size(); ++i) {
+        delete batch_[i];
+    }
+    std::string().swap(batch_.back()->header);
+    std::string().swap(batch_.back()->message);
+    
+    queued_messages_ -= batch_.size();
+    queued_bytes_ -= bytes;
+    batch_.clear();
+    iov_.clear();
+    
+    if (reader_waiting_) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        capacity_cv_.notify_all();
+    }
+}
+
+} // namespace mcp
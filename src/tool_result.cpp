@@ -0,0 +1,86 @@
+#include <cppmcp/tool_result.hpp>
+#include <cppmcp/base64.hpp>
+#include <cppmcp/json_writer.hpp>
+
+namespace mcp {
+
+// Blocks are written with their keys in sorted order, the same layout
+// json::dump() gives a content block
+static const char kPrefix[] = "{\"content\":[";
+
+ToolResult::ToolResult()
+    : serialized_(kPrefix), empty_(true), is_error_(false) {}
+
+ToolResult ToolResult::text(std::string_view text) {
+    ToolResult result;
+    result.add_text(text);
+    return result;
+}
+
+void ToolResult::begin_block() {
+    if (!empty_) {
+        serialized_ += ',';
+    }
+    empty_ = false;
+}
+
+ToolResult& ToolResult::add_text(std::string_view text) {
+    begin_block();
+    serialized_ += "{\"text\":";
+    write_json_string(serialized_, text);
+    serialized_ += ",\"type\":\"text\"}";
+    return *this;
+}
+
+ToolResult& ToolResult::add_image(std::string_view data, std::string_view mime_type) {
+    begin_block();
+    serialized_ += "{\"data\":\"";
+    base64_encode_append(serialized_, data.data(), data.size());
+    serialized_ += "\",\"mimeType\":";
+    write_json_string(serialized_, mime_type);
+    serialized_ += ",\"type\":\"image\"}";
+    return *this;
+}
+
+ToolResult& ToolResult::add_resource(std::string_view uri, std::string_view text,
+                                     std::string_view mime_type) {
+    begin_block();
+    serialized_ += "{\"resource\":{\"mimeType\":";
+    write_json_string(serialized_, mime_type);
+    serialized_ += ",\"text\":";
+    write_json_string(serialized_, text);
+    serialized_ += ",\"uri\":";
+    write_json_string(serialized_, uri);
+    serialized_ += "},\"type\":\"resource\"}";
+    return *this;
+}
+
+ToolResult& ToolResult::add_resource_blob(std::string_view uri, std::string_view data,
+                                          std::string_view mime_type) {
+    begin_block();
+    serialized_ += "{\"resource\":{\"blob\":\"";
+    base64_encode_append(serialized_, data.data(), data.size());
+    serialized_ += "\",\"mimeType\":";
+    write_json_string(serialized_, mime_type);
+    serialized_ += ",\"uri\":";
+    write_json_string(serialized_, uri);
+    serialized_ += "},\"type\":\"resource\"}";
+    return *this;
+}
+
+ToolResult& ToolResult::set_error(bool is_error) {
+    is_error_ = is_error;
+    return *this;
+}
+
+std::string ToolResult::release() {
+    std::string result = std::move(serialized_);
+    result += is_error_ ? "],\"isError\":true}" : "]}";
+
+    serialized_ = kPrefix;
+    empty_ = true;
+    is_error_ = false;
+    return result;
+}
+
+} // namespace mcp
@@ -0,0 +1,146 @@
+#include <cppmcp/worker_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+namespace mcp {
+
+WorkerPool::WorkerPool(size_t threads, size_t max_queued)
+    : max_queued_(max_queued > 0 ? max_queued : 1), active_(0), stopping_(false) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    space_cv_.notify_all();
+    
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this] { return queue_.size() < max_queued_ || stopping_; });
+        if (stopping_) {
+            return;
+        }
+        queue_.push_back(std::move(task));
+    }
+    work_cv_.notify_one();
+}
+
+bool WorkerPool::try_submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= max_queued_) {
+            return false;
+        }
+        queue_.push_back(std::move(task));
+    }
+    work_cv_.notify_one();
+    return true;
+}
+
+void WorkerPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+}
+
+void WorkerPool::parallel_for(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    
+    struct State {
+        std::atomic<size_t> next{0};
+        size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+    
+    // Each runner claims indices until none are left. A helper that only
+    // starts after everything is claimed exits without touching body.
+    auto run = [state, &body, count]() {
+        size_t index;
+        while ((index = state->next.fetch_add(1)) < count) {
+            try {
+                body(index);
+            } catch (const std::exception& e) {
+                std::cerr << "Parallel task failed: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Parallel task failed with unknown exception" << std::endl;
+            }
+            
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->done == count) {
+                state->cv.notify_all();
+            }
+        }
+    };
+    
+    size_t helpers = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        if (!try_submit(run)) {
+            break;
+        }
+    }
+    
+    run();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, count] { return state->done == count; });
+}
+
+void WorkerPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+            
+            // Drain remaining work before shutting down
+            if (queue_.empty()) {
+                return;
+            }
+            
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            ++active_;
+        }
+        space_cv_.notify_one();
+        
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Worker task failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Worker task failed with unknown exception" << std::endl;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+            if (queue_.empty() && active_ == 0) {
+                idle_cv_.notify_all();
+            }
+        }
+    }
+}
+
+} // namespace mcp
@@ -1,6 +1,19 @@
 // Basic client tests
 #include <cppmcp/mcp_client.hpp>
+#include <cppmcp/message_encoding.hpp>
+#include <cppmcp/message_limits.hpp>
+#include <cppmcp/stdio_transport.hpp>
 #include <iostream>
+#include <thread>
+#include <unistd.h>
+
+#define EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << "✗ " << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; \
+            return 1; \
+        } \
+    } while (0)
 
 int main() {
     std::cout << "Running client tests...\n";
@@ -9,6 +22,114 @@ int main() {
     mcp::MCPClient client("test-client", "1.0.0");
     std::cout << "✓ Client created\n";
     
+    // Test 2: Binary message encodings
+    {
+        using mcp::MessageEncoding;
+        EXPECT(mcp::encoding_from_content_type("application/cbor") == MessageEncoding::CBOR);
+        EXPECT(mcp::encoding_from_content_type("Application/MsgPack; charset=binary") == MessageEncoding::MessagePack);
+        EXPECT(mcp::encoding_from_content_type("application/json") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_content_type("") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_accept("application/json, text/event-stream") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_accept("application/json;q=0.5, application/vnd.msgpack") == MessageEncoding::MessagePack);
+        EXPECT(mcp::encoding_from_accept("application/cbor,application/msgpack") == MessageEncoding::CBOR);
+        EXPECT(mcp::encoding_from_accept("application/json, application/cbor") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_accept("application/cbor;q=0.8, application/json; Q=0.9") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_accept("text/event-stream, application/msgpack;q=0") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_accept("*/*, application/cbor;q=0.1") == MessageEncoding::JSON);
+        EXPECT(mcp::encoding_from_accept("*/*;q=0.1, application/cbor") == MessageEncoding::CBOR);
+        
+        json message = {
+            {"jsonrpc", "2.0"}, {"id", 1}, {"method", "tools/call"},
+            {"params", {{"name", "write"}, {"arguments", {{"text", std::string("quote \" nul \0 end", 16)}, {"n", -1.5}}}}}
+        };
+        for (auto encoding : {MessageEncoding::JSON, MessageEncoding::CBOR, MessageEncoding::MessagePack}) {
+            std::string body = mcp::encode_message(message, encoding);
+            EXPECT(mcp::decode_message(body, encoding) == message);
+        }
+        
+        // Serialized responses are transcoded without a document
+        json response = {
+            {"jsonrpc", "2.0"}, {"id", nullptr},
+            {"result", {{"items", {true, false, nullptr, 0, 23, 24, 255, 65536, 4294967296ULL,
+                                   -1, -33, -200, -40000, -3000000000LL, INT64_MIN, UINT64_MAX, 0.1, -2.5e300}},
+                        {"text", std::string(70000, 'x')}, {"short", "\u00e9\n"},
+                        {"empty", json::object()}, {"nested", {{{"a", {1, {2}}}}}}}}
+        };
+        std::string escaped = R"({"s":"a\"b\\c\/d\b\f\n\r\t\u0001\u00e9\ud83d\ude00 end","big":1.5e300,"n":18446744073709551616, "e":[ ] })";
+        for (auto encoding : {MessageEncoding::JSON, MessageEncoding::CBOR, MessageEncoding::MessagePack}) {
+            std::string body = mcp::encode_message_text(response.dump(), encoding);
+            EXPECT(mcp::decode_message(body, encoding) == response);
+            if (encoding != MessageEncoding::JSON) {
+                EXPECT(mcp::decode_message(mcp::encode_message_text(escaped, encoding), encoding) ==
+                       json::parse(escaped));
+            }
+        }
+        for (const char* malformed : {"{\"a\":}", "[1,]", "\"\\ud800\"", "01", "[1] 2", "{\"a\" 1}"}) {
+            bool threw = false;
+            try {
+                mcp::encode_message_text(malformed, MessageEncoding::CBOR);
+            } catch (const json::exception&) {
+                threw = true;
+            }
+            EXPECT(threw);
+        }
+        
+        bool threw = false;
+        try {
+            mcp::decode_message("\xff", MessageEncoding::CBOR);
+        } catch (const json::exception&) {
+            threw = true;
+        }
+        EXPECT(threw);
+        
+        // Depth limits apply to binary input too, without deep recursion
+        std::string nested(100000, '\x81');  // CBOR: array of one element, repeated
+        nested += '\x01';
+        threw = false;
+        try {
+            mcp::decode_message(nested, MessageEncoding::CBOR, 64);
+        } catch (const mcp::MessageLimitError& e) {
+            threw = !e.size_exceeded();
+        }
+        EXPECT(threw);
+        EXPECT(mcp::decode_message(mcp::encode_message(message, MessageEncoding::MessagePack),
+                                   MessageEncoding::MessagePack, 4) == message);
+        
+        client.set_encoding(MessageEncoding::CBOR);
+    }
+    std::cout << "✓ Message encodings\n";
+    
+    // Test 3: Content-Length frames are read whole, however large
+    {
+        int fds[2];
+        EXPECT(pipe(fds) == 0);
+        std::string body = json({{"jsonrpc", "2.0"}, {"id", 1}, {"result", std::string(4 * 1024 * 1024, 'x')}}).dump();
+        std::thread server([&] {
+            std::string stream = mcp::content_length_header(body.size()) + body +
+                                 "\r\n" + mcp::content_length_header(2) + "{}";
+            for (size_t pos = 0; pos < stream.size();) {
+                ssize_t count = write(fds[1], stream.data() + pos, stream.size() - pos);
+                pos += count > 0 ? static_cast<size_t>(count) : 0;
+            }
+            close(fds[1]);
+        });
+        
+        mcp::FrameReader reader(fds[0]);
+        mcp::MessageLimiter limiter(0, 0);
+        std::string message;
+        EXPECT(reader.read(message, limiter));
+        EXPECT(reader.framing() == mcp::StdioFraming::ContentLength);
+        EXPECT(message == body);
+        EXPECT(reader.read(message, limiter));
+        EXPECT(message == "{}");
+        EXPECT(!reader.read(message, limiter));
+        server.join();
+        close(fds[0]);
+        
+        client.set_stdio_framing(mcp::StdioFraming::ContentLength);
+    }
+    std::cout << "✓ STDIO framing\n";
+    
     std::cout << "\nAll tests passed!\n";
     return 0;
 }
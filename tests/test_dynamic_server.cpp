@@ -0,0 +1,114 @@
+// Dynamic server executor tests
+#include <cppmcp/dynamic_mcp_server.hpp>
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+#define EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << "✗ " << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; \
+            return 1; \
+        } \
+    } while (0)
+
+int main() {
+    std::cout << "Running dynamic server tests...\n";
+
+    // Test 1: Terminal executor captures output
+    dynamic_mcp::TerminalExecutor terminal;
+    json result = terminal.execute({{"command", "echo {word}"}}, {{"word", "hello"}});
+    EXPECT(result["success"] == true);
+    EXPECT(result["stdout"] == "hello\n");
+    result = terminal.execute({{"command", "exit 3"}}, json::object());
+    EXPECT(result["returncode"] == 3);
+    std::cout << "✓ Terminal executor\n";
+
+    // Test 2: Cancelling the request kills the running command
+    {
+        auto token = std::make_shared<mcp::CancellationToken>();
+        mcp::RequestContext context(1, token);
+        mcp::RequestContext::Scope scope(&context);
+
+        std::thread canceller([token] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            token->cancel();
+        });
+        auto start = std::chrono::steady_clock::now();
+        result = terminal.execute({{"command", "sleep 5"}}, json::object());
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        canceller.join();
+
+        EXPECT(result["success"] == false);
+        EXPECT(elapsed < std::chrono::seconds(2));
+    }
+    std::cout << "✓ Terminal executor cancellation\n";
+
+    // Test 3: Configured and request timeouts are enforced
+    {
+        auto start = std::chrono::steady_clock::now();
+        result = terminal.execute({{"command", "sleep 5"}, {"timeout", 0.2}}, json::object());
+        EXPECT(result["success"] == false);
+        EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+
+        auto token = std::make_shared<mcp::CancellationToken>();
+        token->set_deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(200));
+        mcp::RequestContext context(2, token);
+        mcp::RequestContext::Scope scope(&context);
+
+        start = std::chrono::steady_clock::now();
+        result = terminal.execute({{"command", "sleep 5"}, {"timeout", 30}}, json::object());
+        EXPECT(result["success"] == false);
+        EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    }
+    std::cout << "✓ Terminal executor timeouts\n";
+
+    // Test 4: CSV splitting matches line/cell semantics of std::getline
+    {
+        dynamic_mcp::DataProcessingExecutor processing;
+        result = processing.execute({{"processor", "csv_transformer"}},
+                                    {{"csv_data", "a,b,c\n\nd,,e\nf,g,\nh"}});
+        EXPECT(result["row_count"] == 4);
+        EXPECT((result["rows"][1] == json{"d", "", "e"}));
+        EXPECT((result["rows"][2] == json{"f", "g"}));
+        EXPECT((result["rows"][3] == json{"h"}));
+        result = processing.execute({{"processor", "csv_transformer"}}, {{"csv_data", 42}});
+        EXPECT(result["success"] == false);
+    }
+    std::cout << "✓ CSV transformer\n";
+
+    // Test 5: The generated schema accepts what validate_parameter_type does
+    {
+        char path[] = "/tmp/dynamic_config_XXXXXX";
+        int fd = mkstemp(path);
+        EXPECT(fd >= 0);
+        std::string config = json({{"tasks", {{
+            {"name", "echo"}, {"description", "Echo"}, {"operation_type", "terminal"},
+            {"config", {{"command", "echo {value} {count}"}}},
+            {"parameters", {{{"name", "value"}, {"type", "any"}}, {{"name", "count"}, {"type", "int"}}}}
+        }}}}).dump();
+        EXPECT(write(fd, config.data(), config.size()) == static_cast<ssize_t>(config.size()));
+        close(fd);
+        dynamic_mcp::ConfigLoader loader(path);
+        EXPECT(loader.load());
+        unlink(path);
+
+        mcp::MCPServer server("dynamic-test");
+        dynamic_mcp::DynamicToolGenerator generator(loader);
+        generator.generate_all_tools(server);
+        server.handle_message({{"jsonrpc", "2.0"}, {"id", 1}, {"method", "initialize"}, {"params", json::object()}});
+        EXPECT(dynamic_mcp::validate_parameter_type("any", 5));
+        auto call = [&](const json& arguments) {
+            return server.handle_message({{"jsonrpc", "2.0"}, {"id", 2}, {"method", "tools/call"},
+                                          {"params", {{"name", "echo"}, {"arguments", arguments}}}});
+        };
+        EXPECT(call({{"value", 5}, {"count", 1}}).contains("result"));
+        EXPECT(call({{"value", "x"}, {"count", "1"}})["error"]["code"] == -32602);
+    }
+    std::cout << "✓ Parameter types\n";
+
+    std::cout << "\nAll tests passed!\n";
+    return 0;
+}
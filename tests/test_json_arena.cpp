@@ -0,0 +1,102 @@
+// JSON arena tests
+#include <cppmcp/json_arena.hpp>
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <thread>
+
+#define EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << "✗ " << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; \
+            return 1; \
+        } \
+    } while (0)
+
+// Arena-backed document type, independent of CPPMCP_ENABLE_JSON_ARENA
+using arena_json = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                                        std::int64_t, std::uint64_t, double,
+                                        mcp::ArenaAllocator>;
+
+int main() {
+    std::cout << "Running JSON arena tests...\n";
+
+    // Test 1: Documents built in a scope come from the arena
+    {
+        mcp::JsonArena arena;
+        {
+            mcp::JsonArena::Scope scope(arena);
+            arena_json doc = arena_json::parse(R"({"a":[1,2,3],"b":{"c":"text"}})");
+            EXPECT(doc["a"][2] == 3);
+            EXPECT(doc["b"]["c"] == "text");
+            EXPECT(arena.bytes_allocated() > 0);
+        }
+        EXPECT(mcp::JsonArena::current() == nullptr);
+
+        // Outside a scope allocations fall back to the heap
+        size_t before = arena.bytes_allocated();
+        arena_json heap_doc = {{"x", 1}};
+        EXPECT(arena.bytes_allocated() == before);
+
+        arena.reset();
+        EXPECT(arena.bytes_allocated() == 0);
+    }
+    std::cout << "✓ Arena allocation\n";
+
+    // Test 2: Documents outliving a reset stay valid
+    {
+        mcp::JsonArena arena(1024);
+        arena_json survivor;
+        {
+            mcp::JsonArena::Scope scope(arena);
+            survivor = arena_json::parse(R"({"keep":["me","around"],"n":42})");
+            arena_json temporary = arena_json::array({1, 2, 3});
+        }
+        arena.reset();
+
+        // New allocations must not overwrite the survivor's chunk
+        {
+            mcp::JsonArena::Scope scope(arena);
+            for (int i = 0; i < 100; ++i) {
+                arena_json filler = {{"filler", i}, {"list", {i, i, i}}};
+            }
+        }
+        EXPECT(survivor["keep"][1] == "around");
+        EXPECT(survivor["n"] == 42);
+    }
+    std::cout << "✓ Documents outlive reset\n";
+
+    // Test 3: Documents can be released on another thread
+    {
+        mcp::JsonArena arena;
+        arena_json doc;
+        {
+            mcp::JsonArena::Scope scope(arena);
+            doc = arena_json::parse(R"([{"id":1},{"id":2}])");
+        }
+        std::thread releaser([moved = std::move(doc)]() mutable {
+            arena_json local = std::move(moved);
+        });
+        releaser.join();
+        arena.reset();
+    }
+    std::cout << "✓ Cross-thread release\n";
+
+    // Test 4: RequestScope rewinds the thread arena for the next request
+    {
+        size_t first_used = 0;
+        for (int request = 0; request < 3; ++request) {
+            mcp::JsonArena::RequestScope scope;
+            arena_json doc = arena_json::parse(R"({"method":"tools/call","params":{"name":"x"}})");
+            EXPECT(mcp::JsonArena::current() == &mcp::JsonArena::thread_arena());
+            if (request == 0) {
+                first_used = mcp::JsonArena::thread_arena().bytes_allocated();
+            }
+            EXPECT(mcp::JsonArena::thread_arena().bytes_allocated() == first_used);
+        }
+        EXPECT(mcp::JsonArena::thread_arena().bytes_allocated() == 0);
+    }
+    std::cout << "✓ Request scope\n";
+
+    std::cout << "\nAll tests passed!\n";
+    return 0;
+}
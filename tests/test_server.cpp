@@ -1,24 +1,1087 @@
 // Basic server tests
+#include <cppmcp/base64.hpp>
+#include <cppmcp/event_loop.hpp>
 #include <cppmcp/mcp_server.hpp>
+#include <cppmcp/message_limits.hpp>
+#include <cppmcp/stdio_transport.hpp>
+#include <cppmcp/worker_pool.hpp>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << "✗ " << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; \
+            return 1; \
+        } \
+    } while (0)
+
+// Run a server's STDIO loop over the given input; returns what it wrote
+static std::string run_stdio(mcp::MCPServer& server, const std::string& input) {
+    FILE* in = std::tmpfile();
+    FILE* out = std::tmpfile();
+    std::fwrite(input.data(), 1, input.size(), in);
+    std::rewind(in);
+    server.run_stdio(fileno(in), fileno(out));
+
+    std::string output;
+    std::rewind(out);
+    char buffer[4096];
+    for (size_t count; (count = std::fread(buffer, 1, sizeof(buffer), out)) > 0;) {
+        output.append(buffer, count);
+    }
+    std::fclose(in);
+    std::fclose(out);
+    return output;
+}
+
+// Send a raw HTTP request to the local server; returns the connected socket
+static int http_send(int port, const std::string& text) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size())) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Read until marker has arrived, or to the end of the stream when empty;
+// stops early on timeout
+static std::string http_read(int fd, const std::string& marker = {}) {
+    std::string text;
+    char buffer[4096];
+    while (marker.empty() || text.find(marker) == std::string::npos) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count <= 0) {
+            break;
+        }
+        text.append(buffer, static_cast<size_t>(count));
+    }
+    return text;
+}
+
+static json request(int id, const std::string& method, const json& params = json::object()) {
+    return {{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}};
+}
+
+struct Point {
+    double x;
+    double y;
+};
+CPPMCP_TOOL_ARGS(Point, x, y)
+
+struct PlotArgs {
+    std::string title;
+    std::vector<Point> points;
+    unsigned width;
+    std::optional<bool> grid;
+    json style;
+};
+CPPMCP_TOOL_ARGS(PlotArgs, width, title, points, grid, style)
 
 int main() {
     std::cout << "Running server tests...\n";
-    
+
     // Test 1: Server creation
     mcp::MCPServer server("test-server", "1.0.0");
     std::cout << "✓ Server created\n";
-    
+
     // Test 2: Add tool
-    server.add_tool("test_tool", "Test tool", {}, 
-        [](const json& args) { return json{{"success", true}}; });
+    server.add_tool("test_tool", "Test tool", {},
+        [](const json&) { return json{{"success", true}}; });
     std::cout << "✓ Tool added\n";
-    
+
     // Test 3: Add resource
     server.add_resource("test://resource", "Test", "desc", "text/plain",
         []() { return "data"; });
     std::cout << "✓ Resource added\n";
-    
+
+    // Test 4: Method routing
+    json response = server.handle_message(request(1, "ping"));
+    EXPECT(response.contains("result"));
+
+    response = server.handle_message(request(2, "tools/list"));
+    EXPECT(response["error"]["code"] == -32002);
+
+    response = server.handle_message(request(3, "initialize", {{"clientInfo", {{"name", "test"}}}}));
+    EXPECT(response["result"]["serverInfo"]["name"] == "test-server");
+
+    response = server.handle_message(request(4, "tools/list"));
+    EXPECT(response["result"]["tools"].size() == 1);
+
+    response = server.handle_message(request(5, "no/such/method"));
+    EXPECT(response["error"]["code"] == -32601);
+    std::cout << "✓ Built-in methods routed\n";
+
+    // Test 5: Custom method registration
+    server.register_method("vendor/echo", [](const json& params) { return params; });
+    response = server.handle_message(request(6, "vendor/echo", {{"value", 42}}));
+    EXPECT(response["id"] == 6);
+    EXPECT(response["result"]["value"] == 42);
+    std::cout << "✓ Custom method registered\n";
+
+    // Test 6: Notifications get no response
+    response = server.handle_message({{"jsonrpc", "2.0"}, {"method", "notifications/initialized"}});
+    EXPECT(response.is_null());
+    response = server.handle_message(request(7, "ping"));
+    EXPECT(response["id"] == 7);
+    response = server.handle_message({{"jsonrpc", "2.0"}, {"id", "abc"}, {"method", "ping"}});
+    EXPECT(response["id"] == "abc");
+    std::cout << "✓ Notifications and string ids handled\n";
+
+    // Test 7: Worker pool runs queued tasks
+    {
+        mcp::WorkerPool pool(4, 8);
+        std::atomic<int> count{0};
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count] { ++count; });
+        }
+        pool.wait_idle();
+        EXPECT(count == 100);
+    }
+    std::cout << "✓ Worker pool\n";
+
+    // Test 8: Concurrent STDIO answers fast requests before slow ones
+    {
+        mcp::MCPServer concurrent("concurrent-server");
+        concurrent.add_tool("slow", "Slow tool", json::object(), [](const json&) -> json {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            return "slow done";
+        });
+        concurrent.set_worker_threads(2);
+
+        std::string output = run_stdio(concurrent, 
+            request(1, "initialize").dump() + "\n" +
+            request(2, "tools/call", {{"name", "slow"}}).dump() + "\n" +
+            request(3, "tools/list").dump() + "\n");
+
+        std::vector<json> responses;
+        std::istringstream lines(output);
+        for (std::string line; std::getline(lines, line);) {
+            responses.push_back(json::parse(line));
+        }
+        EXPECT(responses.size() == 3);
+        EXPECT(responses[1]["id"] == 3);
+        EXPECT(responses[2]["id"] == 2);
+    }
+    std::cout << "✓ Concurrent STDIO responses are matched by id\n";
+
+    // Test 9: Batch requests
+    response = server.handle_message(json::array({
+        request(10, "ping"),
+        {{"jsonrpc", "2.0"}, {"method", "notifications/initialized"}},
+        request(11, "tools/call", {{"name", "test_tool"}})
+    }));
+    EXPECT(response.is_array() && response.size() == 2);
+    EXPECT(response[0]["id"] == 10);
+    EXPECT(response[1]["id"] == 11);
+    EXPECT(server.handle_message(json::array())["error"]["code"] == -32600);
+    EXPECT(server.handle_message(json::array({1}))[0]["error"]["code"] == -32600);
+
+    {
+        mcp::MCPServer parallel("parallel-server");
+        parallel.add_tool("sleep", "Sleep", json::object(), [](const json&) -> json {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            return "ok";
+        });
+        parallel.set_worker_threads(4);
+        parallel.handle_message(request(1, "initialize"));
+
+        json batch = json::array();
+        for (int i = 0; i < 4; ++i) {
+            batch.push_back(request(100 + i, "tools/call", {{"name", "sleep"}}));
+        }
+        auto start = std::chrono::steady_clock::now();
+        response = parallel.handle_message(batch);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        EXPECT(response.size() == 4);
+        EXPECT(response[3]["id"] == 103);
+        EXPECT(elapsed < std::chrono::milliseconds(700));
+    }
+    std::cout << "✓ Batch requests fan out\n";
+
+    // Test 10: Catalog responses are cached and invalidated on registration
+    {
+        std::string raw = server.handle_message_raw(request(20, "tools/list"));
+        json expected = {{"jsonrpc", "2.0"}, {"id", 20}, {"result", {{"tools", json::array({
+            {{"name", "test_tool"}, {"description", "Test tool"}, {"inputSchema", nullptr}}
+        })}}}};
+        EXPECT(raw == expected.dump());
+        EXPECT(server.handle_message_raw(request(20, "tools/list")) == raw);
+
+        server.add_tool("another_tool", "Another", {{"type", "object"}},
+            [](const json&) { return json("ok"); });
+        response = server.handle_message(request(21, "tools/list"));
+        EXPECT(response["result"]["tools"].size() == 2);
+        EXPECT(response["result"]["tools"][0]["name"] == "another_tool");
+
+        server.add_prompt("greeting", "Greeting", json::array(), [](const json&) { return json::array(); });
+        response = server.handle_message(request(22, "prompts/list"));
+        EXPECT(response["result"]["prompts"][0]["name"] == "greeting");
+        response = server.handle_message(request(23, "resources/list"));
+        EXPECT(response["result"]["resources"][0]["uri"] == "test://resource");
+    }
+    std::cout << "✓ Catalog cache\n";
+
+    // Test 11: Cursor pagination
+    {
+        mcp::MCPServer paged("paged-server");
+        for (int i = 0; i < 5; ++i) {
+            paged.add_tool("tool_" + std::to_string(i), "Tool", json::object(),
+                [](const json&) { return json("ok"); });
+        }
+        paged.set_page_size(2);
+        paged.handle_message(request(1, "initialize"));
+
+        response = paged.handle_message(request(2, "tools/list"));
+        EXPECT(response["result"]["tools"].size() == 2);
+        EXPECT(response["result"]["tools"][1]["name"] == "tool_1");
+        std::string cursor = response["result"]["nextCursor"];
+
+        // Tools added behind the cursor don't shift later pages
+        paged.add_tool("tool_0a", "Tool", json::object(), [](const json&) { return json("ok"); });
+
+        std::vector<std::string> names;
+        while (!cursor.empty()) {
+            response = paged.handle_message(request(3, "tools/list", {{"cursor", cursor}}));
+            for (const auto& tool : response["result"]["tools"]) {
+                names.push_back(tool["name"]);
+            }
+            cursor = response["result"].value("nextCursor", "");
+        }
+        EXPECT((names == std::vector<std::string>{"tool_2", "tool_3", "tool_4"}));
+
+        response = paged.handle_message(request(4, "tools/list", {{"cursor", "%%%"}}));
+        EXPECT(response["error"]["code"] == -32602);
+    }
+    std::cout << "✓ Cursor pagination\n";
+
+    // Test 12: notifications/cancelled stops a running tool
+    {
+        mcp::MCPServer cancellable("cancel-server");
+        std::atomic<bool> observed{false};
+        cancellable.add_tool("wait", "Wait until cancelled", json::object(), [&observed](const json&) -> json {
+            auto* context = mcp::RequestContext::current();
+            for (int i = 0; i < 500 && !context->is_cancelled(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            observed = context->is_cancelled();
+            return "done";
+        });
+        cancellable.handle_message(request(1, "initialize"));
+
+        std::string raw = "unset";
+        std::thread caller([&] {
+            raw = cancellable.handle_message_raw(request(42, "tools/call", {{"name", "wait"}}));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cancellable.handle_message({{"jsonrpc", "2.0"}, {"method", "notifications/cancelled"},
+                                    {"params", {{"requestId", 42}, {"reason", "test"}}}});
+        caller.join();
+        EXPECT(observed);
+        EXPECT(raw.empty());
+    }
+    std::cout << "✓ Request cancellation\n";
+
+    // Test 13: Progress notifications when a progressToken is supplied
+    {
+        server.add_tool("steps", "Reports progress", json::object(), [](const json&) -> json {
+            for (int i = 1; i <= 3; ++i) {
+                mcp::report_progress(i, 3, "step " + std::to_string(i));
+            }
+            return "finished";
+        });
+
+        std::vector<json> notifications;
+        mcp::NotificationSink sink = [&notifications](const std::string& notification) {
+            notifications.push_back(json::parse(notification));
+        };
+        server.handle_message_raw(request(30, "tools/call", {{"name", "steps"}}), sink);
+        EXPECT(notifications.empty());
+
+        std::string raw = server.handle_message_raw(
+            request(31, "tools/call", {{"name", "steps"}, {"_meta", {{"progressToken", "tok"}}}}), sink);
+        EXPECT(json::parse(raw)["id"] == 31);
+        EXPECT(notifications.size() == 3);
+        EXPECT(notifications[2]["method"] == "notifications/progress");
+        EXPECT(notifications[2]["params"]["progressToken"] == "tok");
+        EXPECT(notifications[2]["params"]["progress"] == 3);
+        EXPECT(notifications[2]["params"]["message"] == "step 3");
+    }
+    std::cout << "✓ Progress notifications\n";
+
+    // Test 14: Tool deadlines
+    {
+        server.add_tool("spin", "Runs until cancelled", json::object(), [](const json&) -> json {
+            while (!mcp::current_request_cancelled()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            return "stopped";
+        });
+        server.set_tool_timeout("spin", std::chrono::milliseconds(100));
+
+        auto start = std::chrono::steady_clock::now();
+        response = server.handle_message(request(40, "tools/call", {{"name", "spin"}}));
+        EXPECT(response["error"]["code"] == -32001);
+        EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+
+        // A per-request deadline can only shorten the tool's own
+        server.set_tool_timeout("spin", std::chrono::milliseconds(10000));
+        start = std::chrono::steady_clock::now();
+        response = server.handle_message(request(41, "tools/call",
+            {{"name", "spin"}, {"_meta", {{"timeoutMs", 50}}}}));
+        EXPECT(response["error"]["code"] == -32001);
+        EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+
+        response = server.handle_message(request(42, "tools/call",
+            {{"name", "test_tool"}, {"_meta", {{"timeoutMs", 1000}}}}));
+        EXPECT(response.contains("result"));
+
+        // Deadlines past the clock's range are clamped, not wrapped around
+        for (json huge : {json(1e300), json(UINT64_MAX), json(INT64_MAX)}) {
+            response = server.handle_message(request(43, "tools/call",
+                {{"name", "test_tool"}, {"_meta", {{"timeoutMs", huge}}}}));
+            EXPECT(response.contains("result"));
+        }
+    }
+    std::cout << "✓ Tool deadlines\n";
+
+    // Test 15: Live registry changes announce list_changed
+    {
+        mcp::MCPServer live("live-server");
+        live.add_tool("base", "Base", json::object(), [](const json&) { return json("ok"); });
+        live.handle_message(request(1, "initialize"));
+        EXPECT(live.handle_message(request(2, "initialize"))["result"]["capabilities"]["tools"]["listChanged"] == true);
+
+        // Readers keep answering while a writer adds and removes tools
+        std::atomic<bool> stop{false};
+        std::atomic<bool> reader_ok{true};
+        std::thread reader([&] {
+            while (!stop) {
+                json list = live.handle_message(request(3, "tools/list"));
+                if (!list.contains("result") || list["result"]["tools"].empty()) {
+                    reader_ok = false;
+                }
+            }
+        });
+        for (int i = 0; i < 50; ++i) {
+            std::string name = "temp_" + std::to_string(i);
+            live.add_tool(name, "Temp", json::object(), [](const json&) { return json("ok"); });
+            EXPECT(live.remove_tool(name));
+        }
+        stop = true;
+        reader.join();
+        EXPECT(reader_ok);
+        EXPECT(!live.remove_tool("temp_0"));
+
+        response = live.handle_message(request(4, "tools/call", {{"name", "temp_0"}}));
+        EXPECT(response.contains("error"));
+        response = live.handle_message(request(5, "tools/list"));
+        EXPECT(response["result"]["tools"].size() == 1);
+    }
+    {
+        // Notifications reach clients of a running transport; a batch sends one
+        mcp::MCPServer live("live-server");
+        live.set_worker_threads(1);
+        live.add_tool("watch", "Registers tools while running", json::object(), [&live](const json&) -> json {
+            {
+                mcp::MCPServer::RegistrationBatch batch(live);
+                live.add_tool("extra_a", "Extra", json::object(), [](const json&) { return json("a"); });
+                live.add_tool("extra_b", "Extra", json::object(), [](const json&) { return json("b"); });
+            }
+            live.add_resource("live://r", "R", "Resource", "text/plain", [] { return "r"; });
+            return "registered";
+        });
+
+        std::string output = run_stdio(live, 
+            request(1, "initialize").dump() + "\n" +
+            request(2, "tools/call", {{"name", "watch"}}).dump() + "\n");
+
+        std::vector<std::string> methods;
+        std::istringstream lines(output);
+        for (std::string line; std::getline(lines, line);) {
+            json message = json::parse(line);
+            if (message.contains("method")) {
+                methods.push_back(message["method"]);
+            }
+        }
+        EXPECT((methods == std::vector<std::string>{
+            "notifications/tools/list_changed", "notifications/resources/list_changed"}));
+        // The STDIO client's handshake doesn't initialize in-process callers
+        EXPECT(live.handle_message(request(3, "tools/list"))["error"]["code"] == -32002);
+        live.handle_message(request(4, "initialize"));
+        EXPECT(live.handle_message(request(5, "tools/list"))["result"]["tools"].size() == 3);
+    }
+    std::cout << "✓ Live registry updates\n";
+
+    // Test 16: Asynchronous tools complete without holding a thread
+    {
+        mcp::MCPServer async_server("async-server");
+        std::vector<std::thread> backends;
+        std::mutex backends_mutex;
+        async_server.add_async_tool("fetch", "Completes from another thread", json::object(),
+            [&](const json& args, mcp::ToolCompletion done) {
+                std::lock_guard<std::mutex> lock(backends_mutex);
+                backends.emplace_back([done, args] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                    done.context().report_progress(1, 1);
+                    done.resolve(args.value("value", "fetched"));
+                });
+            });
+        async_server.add_async_tool("fail", "Rejects", json::object(),
+            [](const json&, mcp::ToolCompletion done) { done.reject("backend down"); });
+        async_server.add_async_tool("drop", "Never completes", json::object(),
+            [](const json&, mcp::ToolCompletion) {});
+
+        // Without a worker pool the reader keeps going while fetch is pending
+        std::string output = run_stdio(async_server, 
+            request(1, "initialize").dump() + "\n" +
+            request(2, "tools/call", {{"name", "fetch"}}).dump() + "\n" +
+            request(3, "ping").dump() + "\n");
+
+        std::vector<json> responses;
+        std::istringstream lines(output);
+        for (std::string line; std::getline(lines, line);) {
+            responses.push_back(json::parse(line));
+        }
+        EXPECT(responses.size() == 3);
+        EXPECT(responses[1]["id"] == 3);
+        EXPECT(responses[2]["id"] == 2);
+        EXPECT(responses[2]["result"]["content"][0]["text"] == "fetched");
+
+        // The synchronous entry points wait for the completion
+        async_server.handle_message(request(1, "initialize"));
+        response = async_server.handle_message(request(4, "tools/call",
+            {{"name", "fetch"}, {"arguments", {{"value", "direct"}}}}));
+        EXPECT(response["result"]["content"][0]["text"] == "direct");
+        response = async_server.handle_message(request(5, "tools/call", {{"name", "fail"}}));
+        EXPECT(response["error"]["message"] == "Internal error: Tool execution failed: backend down");
+        response = async_server.handle_message(request(6, "tools/call", {{"name", "drop"}}));
+        EXPECT(response["error"]["code"] == -32603);
+
+        for (auto& backend : backends) {
+            backend.join();
+        }
+    }
+    std::cout << "✓ Asynchronous tools\n";
+
+    // Test 17: Lazy parsing routes from the envelope with the same results
+    {
+        auto make_server = [](int& parsed_calls) {
+            auto s = std::make_unique<mcp::MCPServer>("lazy-server");
+            s->add_tool("echo", "Echoes its arguments", json::object(),
+                [&parsed_calls](const json& args) { ++parsed_calls; return args; });
+            return s;
+        };
+        int eager_calls = 0, lazy_calls = 0;
+        auto eager = make_server(eager_calls);
+        auto lazy = make_server(lazy_calls);
+        lazy->set_lazy_parsing(true);
+
+        std::vector<std::string> messages = {
+            request(1, "tools/call", {{"name", "echo"}}).dump(),  // not initialized yet
+            request(2, "initialize").dump(),
+            request(3, "tools/call", {{"name", "echo"}, {"arguments", {{"text", "h\u00e9llo"}, {"n", {1, 2.5, -3}}}}}).dump(),
+            request(4, "tools/call", {{"name", "missing"}, {"arguments", {{"big", std::string(1000, 'x')}}}}).dump(),
+            R"({"jsonrpc":"2.0","id":"five","method":"tools/call","params":{"arguments":{"a":null},"name":"echo"}})",
+            R"({"jsonrpc":"2.0","id":6,"method":"tools/list","params":{}})",
+            R"({"jsonrpc":"2.0","id":7,"method":"no/such/method"})",
+            R"({"id":8,"method":"ping"})",
+            R"({"jsonrpc":"2.0","id":9,"m\u0065thod":"ping"})",  // escaped key: full parse
+            // Repeated members: full parse, the last one wins
+            R"({"jsonrpc":"2.0","id":12,"method":"tools/call","params":{"name":"echo","arguments":{"a":1}},"params":{"name":"missing"}})",
+            R"({"jsonrpc":"2.0","id":13,"method":"tools/call","params":{"arguments":{"a":1},"name":"missing","name":"echo"}})",
+            "[" + request(10, "ping").dump() + "," + request(11, "tools/list").dump() + "]",
+            R"({"jsonrpc":"2.0","method":"notifications/initialized"})",
+        };
+        for (const auto& message : messages) {
+            EXPECT(lazy->handle_message_text(message) == eager->handle_message_text(message));
+        }
+        EXPECT(eager_calls == 3 && lazy_calls == 3);
+
+        json echoed = json::parse(lazy->handle_message_text(messages[2]));
+        EXPECT(json::parse(echoed["result"]["content"][0]["text"].get<std::string>())["text"] == "h\u00e9llo");
+
+        // Malformed input throws on both paths
+        for (const char* bad : {"{\"id\":1,", "{\"id\":1}x", "{\"id\":01}", "\"\\x\""}) {
+            bool threw = false;
+            try {
+                lazy->handle_message_text(bad);
+            } catch (const json::exception&) {
+                threw = true;
+            }
+            EXPECT(threw);
+        }
+
+        // The same messages through STDIO, dispatched from the scan
+        lazy->set_worker_threads(2);
+        std::string stream;
+        for (size_t i = 1; i < messages.size(); ++i) {
+            stream += messages[i] + "\n";
+        }
+        std::string output = run_stdio(*lazy, stream);
+
+        std::set<std::string> ids;
+        std::istringstream lines(output);
+        for (std::string line; std::getline(lines, line);) {
+            json reply = json::parse(line);
+            for (const auto& entry : reply.is_array() ? reply : json::array({reply})) {
+                ids.insert(entry["id"].dump());
+            }
+        }
+        EXPECT(ids == std::set<std::string>({"2", "3", "4", "\"five\"", "6", "7", "8", "9", "10", "11", "12", "13"}));
+    }
+    std::cout << "✓ Lazy parsing\n";
+
+    // Test 18: Responses are written directly, matching json::dump()
+    {
+        mcp::MCPServer writer_server("writer-server");
+        writer_server.add_tool("same", "Returns its arguments", json::object(),
+            [](const json& args) { return args["value"]; });
+        writer_server.handle_message(request(0, "initialize"));
+
+        const json values[] = {
+            "plain", "quote \" backslash \\ newline \n tab \t nul " + std::string(1, '\0') + " h\u00e9 \U0001F600",
+            {{"nested", {{"text", "a \"b\" \\c\n"}}}, {"list", {1, -2.5, true, nullptr}}},
+            json::array(), 12345678901234LL, 0.1,
+        };
+        for (const auto& value : values) {
+            std::string text = value.is_string() ? value.get<std::string>() : value.dump();
+            json expected = {{"jsonrpc", "2.0"}, {"id", 7}, {"result", {{"content", {{{"type", "text"}, {"text", text}}}}}}};
+            std::string response = writer_server.handle_message_raw(
+                request(7, "tools/call", {{"name", "same"}, {"arguments", {{"value", value}}}}));
+            EXPECT(response == expected.dump());
+        }
+
+        json error = {{"jsonrpc", "2.0"}, {"id", "x\"y"}, {"error", {{"code", -32601}, {"message", "Method not found: a\"b"}}}};
+        EXPECT(writer_server.handle_message_raw(
+            {{"jsonrpc", "2.0"}, {"id", "x\"y"}, {"method", "a\"b"}}) == error.dump());
+    }
+    std::cout << "✓ Direct response writing\n";
+
+    // Test 19: Content tools return pre-built blocks spliced into the response
+    {
+        mcp::MCPServer content_server("content-server");
+        content_server.add_tool("render", "Returns content blocks", json::object(),
+            [](const json&) {
+                return mcp::ToolResult()
+                    .add_text("line \"one\"\n\tline two \x01 h\u00e9 \xff end")
+                    .add_image(std::string("\x89PNG\0", 5), "image/png")
+                    .add_resource("file:///a.txt", "contents", "text/plain")
+                    .add_resource_blob("file:///b.bin", std::string("\0\1\2", 3));
+            });
+        content_server.add_tool("fails", "Reports a tool error", json::object(),
+            [](const json&) { return mcp::ToolResult::text("no such file").set_error(); });
+        content_server.add_async_tool("later", "Resolves with content", json::object(),
+            [](const json&, mcp::ToolCompletion done) { done.resolve(mcp::ToolResult::text("done")); });
+        content_server.handle_message(request(0, "initialize"));
+
+        response = content_server.handle_message(request(1, "tools/call", {{"name", "render"}}));
+        json content = response["result"]["content"];
+        EXPECT(content.size() == 4);
+        EXPECT(content[0] == json({{"type", "text"}, {"text", "line \"one\"\n\tline two \x01 h\u00e9 \xEF\xBF\xBD end"}}));
+        EXPECT(content[1] == json({{"type", "image"}, {"mimeType", "image/png"}, {"data", "iVBORwA="}}));
+        EXPECT(content[2] == json({{"type", "resource"},
+            {"resource", {{"uri", "file:///a.txt"}, {"mimeType", "text/plain"}, {"text", "contents"}}}}));
+        EXPECT(content[3]["resource"]["blob"] == "AAEC");
+        EXPECT(!response["result"].contains("isError"));
+
+        // Same bytes json::dump() would produce for the same document
+        std::string raw = content_server.handle_message_raw(request(1, "tools/call", {{"name", "render"}}));
+        EXPECT(raw == response.dump());
+
+        response = content_server.handle_message(request(2, "tools/call", {{"name", "fails"}}));
+        EXPECT(response["result"]["isError"] == true);
+        EXPECT(response["result"]["content"][0]["text"] == "no such file");
+
+        response = content_server.handle_message(request(3, "tools/call", {{"name", "later"}}));
+        EXPECT(response["result"]["content"][0]["text"] == "done");
+    }
+    std::cout << "✓ Content tool results\n";
+
+    // Test 20: STDIO enforces message size and nesting limits while reading
+    {
+        mcp::MCPServer limited("limited-server");
+        limited.add_tool("size", "Returns the length of text", json::object(),
+            [](const json& args) { return json(args["text"].get_ref<const std::string&>().size()); });
+        limited.set_message_limits(64 * 1024, 16);
+
+        std::string deep = std::string(17, '[') + std::string(17, ']');
+        std::string shallow = std::string(14, '[') + std::string(14, ']');  // 16 levels with the envelope
+        std::string output = run_stdio(limited,
+            request(1, "initialize").dump() + "\n" +
+            request(2, "tools/call", {{"name", "size"}, {"arguments", {{"text", std::string(200 * 1024, 'x')}}}}).dump() + "\n" +
+            request(3, "tools/call", {{"name", "size"}, {"arguments", {{"text", std::string(40 * 1024, '[')}}}}).dump() + "\n" +
+            R"({"jsonrpc":"2.0","id":4,"method":"ping","params":{"deep":)" + deep + "}}\n" +
+            R"({"jsonrpc":"2.0","id":5,"method":"ping","params":{"ok":)" + shallow + "}}\n" +
+            request(6, "ping").dump());  // no trailing newline
+
+        std::vector<json> responses;
+        std::istringstream lines(output);
+        for (std::string line; std::getline(lines, line);) {
+            responses.push_back(json::parse(line));
+        }
+        EXPECT(responses.size() == 6);
+        EXPECT(responses[1]["error"]["code"] == -32600);
+        EXPECT(responses[1]["error"]["message"] == "Invalid Request: message exceeds 65536 bytes");
+        EXPECT(responses[1]["id"].is_null());
+        EXPECT(responses[2]["id"] == 3);  // brackets inside strings don't count
+        EXPECT(responses[2]["result"]["content"][0]["text"] == "40960");
+        EXPECT(responses[3]["error"]["message"] == "Invalid Request: nesting exceeds 16 levels");
+        EXPECT(responses[4]["id"] == 5);
+        EXPECT(responses[5]["id"] == 6);
+    }
+    std::cout << "✓ Message limits\n";
+
+    // Test 21: Binary resources are sent as base64 blobs
+    {
+        mcp::MCPServer blob_server("blob-server");
+        std::string bytes;
+        for (int i = 0; i < 1000; ++i) {
+            bytes += static_cast<char>(i * 7);
+        }
+        blob_server.add_blob_resource("file:///model.bin", "Model", "Weights", "application/octet-stream",
+            [bytes] { return bytes; });
+        blob_server.add_resource("file:///notes.txt", "Notes", "Text", "text/plain",
+            [] { return "caf\u00e9 \"notes\""; });
+        blob_server.handle_message(request(0, "initialize"));
+
+        response = blob_server.handle_message(request(1, "resources/read", {{"uri", "file:///model.bin"}}));
+        json contents = response["result"]["contents"];
+        EXPECT(contents.size() == 1);
+        EXPECT(contents[0]["uri"] == "file:///model.bin");
+        EXPECT(contents[0]["mimeType"] == "application/octet-stream");
+        EXPECT(!contents[0].contains("text"));
+        std::string decoded;
+        EXPECT(mcp::base64_decode(contents[0]["blob"], decoded) && decoded == bytes);
+
+        // Every tail length around the vectorized block size
+        for (size_t size = 0; size <= 40; ++size) {
+            std::string encoded;
+            mcp::base64_encode_append(encoded, bytes.data(), size);
+            EXPECT(mcp::base64_decode(encoded, decoded) && decoded == bytes.substr(0, size));
+        }
+        EXPECT(mcp::base64_encode("foobar") == "Zm9vYmFy");
+        EXPECT(mcp::base64_encode(std::string("\xfb\xff\xbf", 3)) == "+/+/");
+
+        std::string raw = blob_server.handle_message_raw(request(2, "resources/read", {{"uri", "file:///notes.txt"}}));
+        json expected = {{"jsonrpc", "2.0"}, {"id", 2}, {"result", {{"contents", {{
+            {"uri", "file:///notes.txt"}, {"mimeType", "text/plain"}, {"text", "caf\u00e9 \"notes\""}}}}}}};
+        EXPECT(raw == expected.dump());
+    }
+    std::cout << "✓ Binary resources\n";
+
+    // Test 22: Arguments are checked against the compiled input_schema
+    {
+        mcp::MCPServer schema_server("schema-server");
+        int calls = 0;
+        schema_server.add_tool("resize", "Resizes an image", {
+            {"type", "object"},
+            {"properties", {
+                {"path", {{"type", "string"}, {"minLength", 1}}},
+                {"width", {{"type", "integer"}, {"minimum", 1}, {"maximum", 4096}}},
+                {"mode", {{"enum", {"fit", "fill"}}}},
+                {"tags", {{"type", "array"}, {"items", {{"type", "string"}}}, {"maxItems", 2}}}
+            }},
+            {"required", {"path", "width"}},
+            {"additionalProperties", false}
+        }, [&calls](const json&) { ++calls; return json("ok"); });
+        schema_server.add_tool("anything", "No constraints", json::object(),
+            [&calls](const json&) { ++calls; return json("ok"); });
+        schema_server.handle_message(request(0, "initialize"));
+
+        auto call = [&](const char* name, const json& arguments) {
+            return schema_server.handle_message(request(1, "tools/call", {{"name", name}, {"arguments", arguments}}));
+        };
+        auto rejects = [&](const json& arguments, const std::string& message) {
+            json error = call("resize", arguments)["error"];
+            return error["code"] == -32602 && error["message"] == "Invalid arguments for tool resize: " + message;
+        };
+
+        EXPECT(call("resize", {{"path", "a.png"}, {"width", 640}, {"tags", {"x"}}})["result"]["content"][0]["text"] == "ok");
+        EXPECT(call("resize", {{"path", "a.png"}, {"width", 640.0}, {"mode", "fit"}}).contains("result"));
+        EXPECT(rejects({{"path", "a.png"}}, "arguments: missing required property 'width'"));
+        EXPECT(rejects({{"path", "a.png"}, {"width", "640"}}, "width: expected integer, got string"));
+        EXPECT(rejects({{"path", "a.png"}, {"width", 0.5}}, "width: expected integer, got number"));
+        EXPECT(rejects({{"path", "a.png"}, {"width", 5000}}, "width: must be at most 4096"));
+        EXPECT(rejects({{"path", ""}, {"width", 1}}, "path: must be at least 1 characters"));
+        EXPECT(rejects({{"path", "a"}, {"width", 1}, {"mode", "crop"}}, "mode: value is not one of the allowed values"));
+        EXPECT(rejects({{"path", "a"}, {"width", 1}, {"tags", {"x", 2}}}, "tags[1]: expected string, got integer"));
+        EXPECT(rejects({{"path", "a"}, {"width", 1}, {"tags", {"x", "y", "z"}}}, "tags: must have at most 2 items"));
+        EXPECT(rejects({{"path", "a"}, {"width", 1}, {"height", 2}}, "arguments: unexpected property 'height'"));
+        EXPECT(rejects(json::array(), "arguments: expected object, got array"));
+        EXPECT(calls == 2);
+
+        EXPECT(call("anything", json::array()).contains("result"));
+        EXPECT(calls == 3);
+
+        // Lazily parsed arguments are checked the same way
+        schema_server.set_lazy_parsing(true);
+        json error = json::parse(schema_server.handle_message_text(
+            R"({"jsonrpc":"2.0","id":2,"method":"tools/call","params":{"name":"resize","arguments":{"path":7}}})"))["error"];
+        EXPECT(error["code"] == -32602);
+        EXPECT(calls == 3);
+
+        bool threw = false;
+        try {
+            schema_server.add_tool("bad", "Malformed schema", {{"type", "strnig"}}, [](const json&) { return json(); });
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        EXPECT(threw);
+    }
+    std::cout << "✓ Input schema validation\n";
+
+    // Test 23: Typed tools generate their schema and decode into a struct
+    {
+        mcp::MCPServer typed_server("typed-server");
+        typed_server.add_tool<PlotArgs>("plot", "Plots points", {{"title", "Chart title"}},
+            [](const PlotArgs& args) {
+                return json{{"title", args.title}, {"count", args.points.size()}, {"last_y", args.points.back().y},
+                            {"width", args.width}, {"grid", args.grid.value_or(false)}, {"style", args.style}};
+            });
+        typed_server.add_tool<Point>("describe", "Describes a point",
+            [](const Point& p) { return mcp::ToolResult::text(std::to_string(p.x + p.y)); });
+        typed_server.handle_message(request(0, "initialize"));
+
+        json tools = typed_server.handle_message(request(1, "tools/list"))["result"]["tools"];
+        json schema = tools[1]["inputSchema"];
+        EXPECT(tools[1]["name"] == "plot");
+        EXPECT(schema["properties"]["title"] == json({{"type", "string"}, {"description", "Chart title"}}));
+        EXPECT(schema["properties"]["width"] ==
+               json({{"type", "integer"}, {"minimum", 0}, {"maximum", std::numeric_limits<unsigned>::max()}}));
+        EXPECT(schema["properties"]["points"]["items"]["properties"]["x"]["type"] == "number");
+        EXPECT(schema["properties"]["grid"] == json({{"type", "boolean"}}));
+        EXPECT(schema["required"] == json({"width", "title", "points", "style"}));
+
+        response = typed_server.handle_message(request(2, "tools/call", {{"name", "plot"}, {"arguments", {
+            {"title", "t"}, {"width", 3}, {"points", {{{"x", 1}, {"y", 2}}, {{"x", 3}, {"y", 4.5}}}},
+            {"style", {{"color", "red"}}}, {"extra", 1}}}}));
+        json result = json::parse(response["result"]["content"][0]["text"].get<std::string>());
+        EXPECT(result == json({{"title", "t"}, {"count", 2}, {"last_y", 4.5}, {"width", 3}, {"grid", false},
+                               {"style", {{"color", "red"}}}}));
+
+        // Values outside the field's range are rejected, not truncated
+        for (json width : {json(-1), json(int64_t(1) << 40)}) {
+            response = typed_server.handle_message(request(3, "tools/call", {{"name", "plot"}, {"arguments", {
+                {"title", "t"}, {"width", width}, {"points", json::array()}, {"style", nullptr}}}}));
+            EXPECT(response["error"]["code"] == -32602);
+        }
+
+        response = typed_server.handle_message(request(4, "tools/call", {{"name", "describe"}, {"arguments", {{"x", 1}, {"y", 2}}}}));
+        EXPECT(response["result"]["content"][0]["text"] == "3.000000");
+    }
+    std::cout << "✓ Typed tools\n";
+
+    // Test 24: STDIO transport reads lines across buffer refills and
+    // writes held output in order once uncorked
+    {
+        std::string long_line(100, 'x');
+        FILE* in = std::tmpfile();
+        FILE* out = std::tmpfile();
+        std::string text = "a\n" + long_line + "\n\nlast";
+        std::fwrite(text.data(), 1, text.size(), in);
+        std::rewind(in);
+
+        mcp::EventLoop loop;
+        {
+            mcp::StdioTransport transport(loop, fileno(in), fileno(out), mcp::StdioFraming::Auto, 0, 16);
+            mcp::MessageLimiter limiter(0, 0);
+            std::vector<std::string> lines;
+            for (std::string line; transport.read(line, limiter);) {
+                lines.push_back(line);
+            }
+            EXPECT(lines == std::vector<std::string>({"a", long_line, "", "last"}));
+
+            transport.cork();
+            transport.write("one");
+            transport.write("two");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT(lseek(fileno(out), 0, SEEK_END) == 0);  // nothing written yet
+            transport.uncork();
+            transport.write("three");
+        }
+
+        std::string written(64, '\0');
+        written.resize(pread(fileno(out), &written[0], written.size(), 0));
+        EXPECT(written == "one\ntwo\nthree\n");
+        std::fclose(in);
+        std::fclose(out);
+    }
+
+    // Test 25: Output the client doesn't read holds back intake, not writers
+    {
+        int fds[2];
+        EXPECT(pipe(fds) == 0);
+        std::atomic<bool> has_capacity{false};
+        std::thread reader;
+        mcp::EventLoop loop;
+        {
+            mcp::StdioTransport transport(loop, -1, fds[1], mcp::StdioFraming::Newline, 1024);
+            transport.write(std::string(1024 * 1024, 'x'));  // Far more than the pipe holds
+            transport.write("tail");
+
+            reader = std::thread([&] {
+                transport.wait_for_capacity();
+                has_capacity = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            EXPECT(!has_capacity);
+
+            // The client catches up
+            size_t total = 0;
+            char buffer[65536];
+            while (total < 1024 * 1024 + 1 + 5) {
+                ssize_t count = read(fds[0], buffer, sizeof(buffer));
+                EXPECT(count > 0);
+                total += static_cast<size_t>(count);
+            }
+            reader.join();
+            EXPECT(has_capacity);
+        }
+        close(fds[0]);
+        close(fds[1]);
+    }
+    std::cout << "✓ STDIO transport\n";
+
+    // Test 26: Content-Length framing is detected and answered in kind;
+    // oversized bodies are skipped without being parsed
+    {
+        mcp::MCPServer framed("framed-server");
+        framed.add_tool("size", "Returns the length of text", json::object(),
+            [](const json& args) { return json(args["text"].get_ref<const std::string&>().size()); });
+        framed.set_message_limits(512 * 1024, 16);
+
+        auto frame = [](const std::string& body) {
+            return mcp::content_length_header(body.size()) + body;
+        };
+        std::string big = request(2, "tools/call", {{"name", "size"}, {"arguments", {{"text", std::string(300 * 1024, 'x')}}}}).dump();
+        std::string output = run_stdio(framed,
+            frame(request(1, "initialize").dump()) +
+            "Content-Type: application/vscode-jsonrpc; charset=utf-8\r\ncontent-length:" +
+                std::to_string(big.size()) + "\r\n\r\n" + big +
+            frame(request(3, "tools/call", {{"name", "size"}, {"arguments", {{"text", std::string(600 * 1024, '{')}}}}).dump()) +
+            "Content-Length: abc\r\n\r\n" +
+            frame(request(4, "ping").dump()));
+
+        std::vector<json> responses;
+        size_t pos = 0;
+        while (pos < output.size()) {
+            EXPECT(output.compare(pos, 16, "Content-Length: ") == 0);
+            size_t header_end = output.find("\r\n\r\n", pos);
+            size_t length = std::stoul(output.substr(pos + 16, header_end - pos - 16));
+            responses.push_back(json::parse(output.substr(header_end + 4, length)));
+            pos = header_end + 4 + length;
+        }
+        EXPECT(responses.size() == 4);
+        EXPECT(responses[0]["id"] == 1);
+        EXPECT(responses[1]["result"]["content"][0]["text"] == "307200");
+        EXPECT(responses[2]["error"]["message"] == "Invalid Request: message exceeds 524288 bytes");
+        EXPECT(responses[3]["id"] == 4);  // the malformed header is skipped
+
+        // Newline clients are unaffected
+        output = run_stdio(framed, request(5, "ping").dump() + "\n");
+        EXPECT(json::parse(output)["id"] == 5);
+    }
+    std::cout << "✓ Content-Length framing\n";
+
+    // Test 27: Event loop timers and deadlines
+    {
+        mcp::EventLoop loop;
+        std::mutex fired_mutex;
+        std::vector<int> fired;
+        auto record = [&](int n) {
+            return [&, n] {
+                std::lock_guard<std::mutex> lock(fired_mutex);
+                fired.push_back(n);
+            };
+        };
+        loop.add_timer(std::chrono::milliseconds(60), record(3));
+        loop.add_timer(std::chrono::milliseconds(20), record(2));
+        auto cancelled = loop.add_timer(std::chrono::milliseconds(40), record(0));
+        loop.post(record(1));
+        loop.cancel_timer(cancelled);
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        loop.call([] {});
+        {
+            std::lock_guard<std::mutex> lock(fired_mutex);
+            EXPECT(fired == std::vector<int>({1, 2, 3}));
+        }
+
+        // An asynchronous tool that overruns its deadline is answered by
+        // the timer; its late completion is dropped
+        mcp::MCPServer timed("timed-server");
+        std::vector<mcp::ToolCompletion> held;
+        timed.add_async_tool("hang", "Completes only when told", json::object(),
+            [&](const json&, mcp::ToolCompletion done) { held.push_back(done); });
+        timed.set_tool_timeout("hang", std::chrono::milliseconds(100));
+        timed.handle_message(request(1, "initialize"));
+
+        auto start = std::chrono::steady_clock::now();
+        response = timed.handle_message(request(2, "tools/call", {{"name", "hang"}}));
+        EXPECT(response["error"]["code"] == -32001);
+        EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+        EXPECT(held.size() == 1);
+        held[0].resolve("too late");
+        held.clear();
+
+        // Over STDIO the tool may outlive the run; what it reports after
+        // the transport is gone is dropped
+        std::string output = run_stdio(timed,
+            request(1, "initialize").dump() + "\n" +
+            request(3, "tools/call", {{"name", "hang"}, {"_meta", {{"progressToken", "p"}}}}).dump() + "\n");
+        EXPECT(output.find("-32001") != std::string::npos);
+        EXPECT(held.size() == 1);
+        held[0].context().report_progress(1, 1);
+        held[0].resolve("too late");
+        held.clear();
+    }
+    std::cout << "✓ Event loop\n";
+
+    // Test 28: Clients of different transports keep separate sessions
+    {
+        mcp::MCPServer shared("shared-server");
+        std::mutex held_mutex;
+        std::vector<mcp::ToolCompletion> held;
+        shared.add_async_tool("hold", "Completes only when told", json::object(),
+            [&](const json&, mcp::ToolCompletion done) {
+                std::lock_guard<std::mutex> lock(held_mutex);
+                held.push_back(done);
+            });
+
+        // An initialized in-process caller doesn't initialize a STDIO client
+        shared.handle_message(request(1, "initialize"));
+        std::string output = run_stdio(shared, request(2, "tools/list").dump() + "\n");
+        EXPECT(json::parse(output)["error"]["code"] == -32002);
+
+        // The same id in flight from both; a cancellation only reaches the
+        // request of the client that sent it
+        int in_fds[2], out_fds[2];
+        EXPECT(pipe(in_fds) == 0 && pipe(out_fds) == 0);
+        std::thread stdio([&] { shared.run_stdio(in_fds[0], out_fds[1]); });
+        std::string input = request(1, "initialize").dump() + "\n" +
+                            request(7, "tools/call", {{"name", "hold"}}).dump() + "\n";
+        EXPECT(write(in_fds[1], input.data(), input.size()) == static_cast<ssize_t>(input.size()));
+
+        std::promise<std::string> in_process;
+        shared.handle_message_async(request(7, "tools/call", {{"name", "hold"}}),
+            [&in_process](std::string response) { in_process.set_value(std::move(response)); });
+        while (true) {
+            std::lock_guard<std::mutex> lock(held_mutex);
+            if (held.size() == 2) break;
+        }
+        shared.handle_message({{"jsonrpc", "2.0"}, {"method", "notifications/cancelled"},
+                               {"params", {{"requestId", 7}}}});
+        {
+            std::lock_guard<std::mutex> lock(held_mutex);
+            EXPECT(held[0].context().is_cancelled() != held[1].context().is_cancelled());
+            for (auto& done : held) {
+                done.resolve("held");
+            }
+            held.clear();
+        }
+        EXPECT(in_process.get_future().get().empty());  // Cancelled requests get no reply
+
+        close(in_fds[1]);
+        stdio.join();
+        close(out_fds[1]);
+        output.clear();
+        char buffer[4096];
+        for (ssize_t count; (count = read(out_fds[0], buffer, sizeof(buffer))) > 0;) {
+            output.append(buffer, static_cast<size_t>(count));
+        }
+        close(in_fds[0]);
+        close(out_fds[0]);
+        std::istringstream lines(output);
+        std::string line;
+        std::getline(lines, line);
+        EXPECT(json::parse(line)["id"] == 1);
+        std::getline(lines, line);
+        EXPECT(json::parse(line)["result"]["content"][0]["text"] == "held");
+    }
+    std::cout << "✓ Sessions\n";
+
+    // Test 29: HTTP sessions. A client without Mcp-Session-Id is
+    // initialized; a reconnected SSE stream closes the one it replaces,
+    // and stop_sse still ends every stream
+    {
+        mcp::MCPServer http("http-server");
+        const int port = 18931;
+        if (!http.start_sse(port)) {
+            std::cout << "- SSE reconnect skipped: port " << port << " unavailable\n";
+        } else {
+            std::string body = request(1, "initialize").dump();
+            int post = http_send(port, "POST / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+                                       "Content-Type: application/json\r\nContent-Length: " +
+                                       std::to_string(body.size()) + "\r\n\r\n" + body);
+            EXPECT(post >= 0);
+            std::string response = http_read(post);
+            close(post);
+            size_t header = response.find("Mcp-Session-Id: ");
+            EXPECT(header != std::string::npos);
+            size_t begin = header + std::string("Mcp-Session-Id: ").size();
+            std::string session_id = response.substr(begin, response.find("\r\n", begin) - begin);
+
+            // A client that doesn't echo the id is still initialized
+            body = request(2, "tools/list").dump();
+            post = http_send(port, "POST / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+                                   "Content-Type: application/json\r\nContent-Length: " +
+                                   std::to_string(body.size()) + "\r\n\r\n" + body);
+            EXPECT(post >= 0);
+            response = http_read(post);
+            close(post);
+            EXPECT(response.find("\"result\"") != std::string::npos);
+
+            std::string get = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+                              "Accept: text/event-stream\r\nMcp-Session-Id: " + session_id + "\r\n\r\n";
+            int first = http_send(port, get);
+            EXPECT(first >= 0);
+            EXPECT(http_read(first, "sessionId=" + session_id).find("event: endpoint") != std::string::npos);
+            int second = http_send(port, get);
+            EXPECT(second >= 0);
+            EXPECT(http_read(second, "sessionId=" + session_id).find("event: endpoint") != std::string::npos);
+
+            // The replaced stream ends on its own, before the timeout
+            auto started = std::chrono::steady_clock::now();
+            http_read(first);
+            EXPECT(std::chrono::steady_clock::now() - started < std::chrono::seconds(4));
+            close(first);
+
+            std::promise<void> stopped;
+            std::thread stopper([&] {
+                http.stop_sse();
+                stopped.set_value();
+            });
+            if (stopped.get_future().wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+                std::cerr << "✗ stop_sse hung after an SSE reconnect\n";
+                std::_Exit(1);
+            }
+            stopper.join();
+            close(second);
+            std::cout << "✓ SSE reconnect\n";
+        }
+    }
+
     std::cout << "\nAll tests passed!\n";
     return 0;
 }